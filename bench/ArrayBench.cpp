@@ -0,0 +1,51 @@
+#include "Bench.hpp"
+#include "Interpreter.hpp"
+#include "Runtime.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+constexpr uint64_t Length = 4096;
+constexpr uint64_t Rounds = 100;
+
+Value (*volatile addFn)(const Value&, const Value&) = addValues;
+
+std::string setup() {
+    return "SET A TO ARRAY(" + std::to_string(Length) + ") + 1.5;\n"
+           "SET B TO ARRAY(" + std::to_string(Length) + ") + 2.5;\n"
+           "SET C TO ARRAY(" + std::to_string(Length) + ");\n";
+}
+
+// The same element-wise sum, once as one + per round and once element by
+// element; the gap is what the kernels save over the interpreter loop.
+std::string wholeArrays() {
+    return setup() + "FOR R = 1 TO " + std::to_string(Rounds) + " {\n"
+                     "    SET C TO A + B;\n"
+                     "};\n";
+}
+
+std::string elementLoop() {
+    return setup() + "FOR R = 1 TO " + std::to_string(Rounds) + " {\n"
+                     "    FOR I = 1 TO " + std::to_string(Length) + " {\n"
+                     "        SET C[I] TO A[I] + B[I];\n"
+                     "    };\n"
+                     "};\n";
+}
+
+} // namespace
+
+void arrayBenchmarks(std::vector<BenchResult>& results) {
+    Value a = zeros(Value(static_cast<double>(Length))), b = zeros(Value(static_cast<double>(Length)));
+    results.push_back(measure("array/add_values", Rounds * Length, [&](uint64_t) {
+        for (uint64_t r = 0; r < Rounds; r++) {
+            Value sum = addFn(a, b);
+            keep(sum.array->data()[0]);
+        }
+    }));
+
+    Program whole = parseSource(wholeArrays());
+    Program loop = parseSource(elementLoop());
+    Interpreter vm;
+    results.push_back(measure("array/add_script_whole", Rounds * Length, [&](uint64_t) { vm.run(whole); }));
+    results.push_back(measure("array/add_script_elements", Rounds * Length, [&](uint64_t) { vm.run(loop); }));
+}
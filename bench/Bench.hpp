@@ -0,0 +1,86 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct BenchOptions {
+    int repetitions = 5;
+    // Only benchmarks whose name contains this run.
+    std::string filter;
+};
+
+inline BenchOptions benchOptions;
+
+// Timings are per repetition of the whole body; the median is the headline
+// number and min/max show how noisy the run was.
+struct BenchResult {
+    std::string name;
+    uint64_t iterations = 0;
+    uint64_t bytes = 0;
+    double seconds = 0;
+    double minSeconds = 0;
+    double maxSeconds = 0;
+    bool skipped = false;
+
+    double nsPerOp() const { return nsPerOp(seconds); }
+    double nsPerOp(double s) const { return iterations ? s * 1e9 / iterations : 0; }
+    double mbPerSec() const { return seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0; }
+    double opsPerSec() const { return seconds > 0 ? iterations / seconds : 0; }
+};
+
+// Runs `body(iterations)` once to warm up and then benchOptions.repetitions
+// times. `bytes` is the input size of one repetition, for throughput.
+template <typename F>
+BenchResult measure(const std::string& name, uint64_t iterations, F&& body, uint64_t bytes = 0) {
+    BenchResult r;
+    r.name = name;
+    r.iterations = iterations;
+    r.bytes = bytes;
+    if (name.find(benchOptions.filter) == std::string::npos) {
+        r.skipped = true;
+        return r;
+    }
+
+    body(iterations);
+
+    std::vector<double> samples;
+    for (int i = 0; i < std::max(1, benchOptions.repetitions); i++) {
+        auto start = std::chrono::steady_clock::now();
+        body(iterations);
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double>(end - start).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    r.seconds = samples[samples.size() / 2];
+    r.minSeconds = samples.front();
+    r.maxSeconds = samples.back();
+    return r;
+}
+
+inline void report(const BenchResult& r) {
+    std::printf("%-36s %12llu iters %10.2f ns/op %14.0f ops/s", r.name.c_str(),
+                static_cast<unsigned long long>(r.iterations), r.nsPerOp(), r.opsPerSec());
+    if (r.bytes)
+        std::printf(" %10.1f MB/s", r.mbPerSec());
+    std::printf("\n");
+}
+
+void writeJson(std::FILE* out, const std::vector<BenchResult>& results);
+
+// Shared by the lexer and parser benchmarks.
+std::string syntheticScript(size_t targetBytes);
+
+// Keeps the optimizer from discarding a computed value.
+template <typename T>
+inline void keep(T const& value) {
+#if defined(_MSC_VER)
+    static volatile const void* sink;
+    sink = &value;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
@@ -0,0 +1,106 @@
+#include "Bench.hpp"
+#include "Jit.hpp"
+#include "Interpreter.hpp"
+#include "Runtime.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+BinaryExpr* makeAdd(Arena& arena, Value left, Value right) {
+    auto l = arena.make<LiteralExpr>();
+    l->value = std::move(left);
+    auto r = arena.make<LiteralExpr>();
+    r->value = std::move(right);
+    auto add = arena.make<BinaryExpr>();
+    add->left = l;
+    add->right = r;
+    add->op = '+';
+    return add;
+}
+
+std::string emptyLoop(uint64_t iterations) {
+    return "FOR I = 1 TO " + std::to_string(iterations) + " {\n"
+           "}\n";
+}
+
+// Sums with a comparison in the body: the kind of loop --jit compiles.
+std::string numericLoop(uint64_t iterations) {
+    return "SET T TO 0;\n"
+           "SET HITS TO 0;\n"
+           "FOR I = 1 TO " + std::to_string(iterations) + " {\n"
+           "    SET T TO T + I + 0.5;\n"
+           "    IF I::IS(1000) THEN { SET HITS TO HITS + 1; };\n"
+           "}\n";
+}
+
+} // namespace
+
+void evalBenchmarks(std::vector<BenchResult>& results) {
+    Arena arena;
+    Interpreter vm;
+    Interpreter walker({.treeWalk = true});
+
+    BinaryExpr* numbers = makeAdd(arena, Value(1.5), Value(2.25));
+    results.push_back(measure("eval/binary_add_number", 10000000, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            keep(numbers->evaluate(walker).number);
+    }));
+
+    BinaryExpr* strings = makeAdd(arena, Value("jorge"), Value("script"));
+    results.push_back(measure("eval/binary_add_string", 2000000, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            keep(strings->evaluate(walker).type);
+    }));
+
+    BinaryExpr* mixed = makeAdd(arena, Value("line "), Value(42.0));
+    results.push_back(measure("eval/binary_add_string_number", 2000000, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            keep(mixed->evaluate(walker).type);
+    }));
+
+    BinaryExpr* equal = makeAdd(arena, Value(3.0), Value(3.0));
+    equal->op = '=';
+    results.push_back(measure("eval/binary_equal_number", 10000000, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++)
+            keep(equal->evaluate(walker).boolean);
+    }));
+
+    const uint64_t loop = 2000000;
+    Program empty = parseSource(emptyLoop(loop));
+    results.push_back(measure("eval/for_iteration_vm", loop, [&](uint64_t) {
+        vm.run(empty);
+    }));
+    results.push_back(measure("eval/for_iteration_tree_walk", loop, [&](uint64_t) {
+        walker.run(empty);
+    }));
+
+    Program numeric = parseSource(numericLoop(loop));
+    results.push_back(measure("eval/numeric_loop_vm", loop, [&](uint64_t) {
+        vm.run(numeric);
+    }));
+    if (Jit::available()) {
+        Interpreter jit({.jit = true});
+        results.push_back(measure("eval/numeric_loop_jit", loop, [&](uint64_t) {
+            jit.run(numeric);
+        }));
+    }
+
+    // A variable defined `depth` SUMMON frames further out than the frame
+    // reading it, which takes the name-based fallback for depth > 0.
+    auto var = arena.make<VariableExpr>();
+    var->name = arena.copy("X");
+    var->slot = 0;
+    for (int depth : {0, 1, 4, 16, 64}) {
+        walker.scopes.clear();
+        walker.pushScope({"X"});
+        walker.scopes.back().slots[0] = {Value(1.0), false, true};
+        for (int d = 0; d < depth; d++)
+            walker.pushScope({"X"});
+
+        results.push_back(measure("eval/lookup_depth_" + std::to_string(depth), 5000000, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++)
+                keep(var->evaluate(walker).number);
+        }));
+    }
+    walker.scopes.clear();
+}
@@ -0,0 +1,70 @@
+#include "Bench.hpp"
+#include "Interpreter.hpp"
+#include "Runtime.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr uint64_t Calls = 2000000;
+
+std::string callLoop() {
+    return "LOADDLL \"" JORGESCRIPT_TESTLIB "\" AS T;\n"
+           "FOR I = 1 TO " + std::to_string(Calls) + " {\n"
+           "    CALL T::jorge_noop(I, \"x\");\n"
+           "}\n";
+}
+
+std::string typedCallLoop() {
+    return "LOADDLL \"" JORGESCRIPT_TESTLIB "\" AS T;\n"
+           "DECLARE T::jorge_add(INT64, INT64) AS INT64;\n"
+           "SET S TO 0;\n"
+           "FOR I = 1 TO " + std::to_string(Calls) + " {\n"
+           "    SET S TO CALL T::jorge_add(S, 1);\n"
+           "}\n";
+}
+
+} // namespace
+
+void ffiBenchmarks(std::vector<BenchResult>& results) {
+    LibraryHandle library = openLibrary(JORGESCRIPT_TESTLIB);
+    if (!library)
+        throw std::runtime_error("Failed to load " JORGESCRIPT_TESTLIB);
+
+    // What every CALL used to do: look the symbol up again before calling.
+    results.push_back(measure("ffi/lookup_per_call", Calls, [&](uint64_t n) {
+        void* args[1] = {nullptr};
+        for (uint64_t i = 0; i < n; i++) {
+            auto fn = reinterpret_cast<LibraryFunction>(findSymbol(library, "jorge_noop"));
+            args[0] = reinterpret_cast<void*>(static_cast<intptr_t>(i));
+            keep(fn(1, args));
+        }
+    }));
+
+    results.push_back(measure("ffi/direct_call", Calls, [&](uint64_t n) {
+        auto fn = reinterpret_cast<LibraryFunction>(findSymbol(library, "jorge_noop"));
+        void* args[1] = {nullptr};
+        for (uint64_t i = 0; i < n; i++) {
+            args[0] = reinterpret_cast<void*>(static_cast<intptr_t>(i));
+            keep(fn(1, args));
+        }
+    }));
+
+    Program program = parseSource(callLoop());
+    Interpreter vm;
+    Interpreter walker({.treeWalk = true});
+    results.push_back(measure("ffi/call_loop_vm", Calls, [&](uint64_t) {
+        vm.run(program);
+    }));
+    results.push_back(measure("ffi/call_loop_tree_walk", Calls, [&](uint64_t) {
+        walker.run(program);
+    }));
+
+    Program typed = parseSource(typedCallLoop());
+    results.push_back(measure("ffi/typed_call_set_vm", Calls, [&](uint64_t) {
+        vm.run(typed);
+    }));
+    results.push_back(measure("ffi/typed_call_set_tree_walk", Calls, [&](uint64_t) {
+        walker.run(typed);
+    }));
+}
@@ -0,0 +1,33 @@
+#include "Bench.hpp"
+#include "Lexer.hpp"
+#include <string>
+#include <vector>
+
+std::string syntheticScript(size_t targetBytes) {
+    std::string out;
+    out.reserve(targetBytes + 512);
+    for (size_t n = 0; out.size() < targetBytes; n++) {
+        std::string id = std::to_string(n);
+        out += "SET COUNTER" + id + " TO " + id + ";\n";
+        out += "PRINT \"a moderately long string literal number " + id + "\";\n";
+        out += "IF FLAG" + id + "::IS(TRUE!) THEN {\n";
+        out += "    SET TOTAL TO TOTAL + 3.25 + 0x1F;\n";
+        out += "}\n";
+        out += "FOR I = 1 TO 100 STEP 2 {\n";
+        out += "    INSIDE ALWAYS SET NAME" + id + " TO \"x\" + I;\n";
+        out += "}\n\n";
+    }
+    return out;
+}
+
+void lexerBenchmarks(std::vector<BenchResult>& results) {
+    std::string src = syntheticScript(8 << 20);
+
+    results.push_back(measure("lexer/next_8mb", 1, [&](uint64_t) {
+        size_t tokens = 0;
+        Lexer lexer(src);
+        while (lexer.next().type != TokenType::END)
+            tokens++;
+        keep(tokens);
+    }, src.size()));
+}
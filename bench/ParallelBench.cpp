@@ -0,0 +1,40 @@
+#include "Bench.hpp"
+#include "Interpreter.hpp"
+#include "Runtime.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr uint64_t Outer = 256;
+constexpr uint64_t Inner = 4000;
+
+// Independent sums: every piece does the same amount of work, so the time
+// per iteration should drop with each thread up to the number of cores.
+std::string sumLoop(const char* keyword) {
+    return "SET T TO 0;\n" + std::string(keyword) + " I = 1 TO " + std::to_string(Outer) +
+           (keyword[0] == 'P' ? " REDUCE T" : "") + " {\n"
+           "    FOR J = 1 TO " + std::to_string(Inner) + " {\n"
+           "        SET T TO T + I + J;\n"
+           "    };\n"
+           "};\n";
+}
+
+} // namespace
+
+void parallelBenchmarks(std::vector<BenchResult>& results) {
+    Program sequential = parseSource(sumLoop("FOR"));
+    Program parallel = parseSource(sumLoop("PARALLEL FOR"));
+
+    Interpreter baseline;
+    results.push_back(measure("parallel/sum_for", Outer * Inner, [&](uint64_t) {
+        baseline.run(sequential);
+    }));
+
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= cores * 2; threads *= 2) {
+        Interpreter vm({.threads = threads});
+        results.push_back(measure("parallel/sum_parallel_for_" + std::to_string(threads) + "_threads", Outer * Inner,
+                                  [&](uint64_t) { vm.run(parallel); }));
+    }
+}
@@ -0,0 +1,24 @@
+#include "Bench.hpp"
+#include "Lexer.hpp"
+#include "Parser.hpp"
+#include "Runtime.hpp"
+#include <string>
+#include <vector>
+
+void parserBenchmarks(std::vector<BenchResult>& results) {
+    std::string src = syntheticScript(1 << 20);
+
+    results.push_back(measure("parser/parse_program_1mb", 1, [&](uint64_t) {
+        Arena arena;
+        Lexer lexer(src);
+        Parser parser(lexer, arena);
+        StatementList statements = parser.parseProgram();
+        keep(statements.size());
+    }, src.size()));
+
+    // Parsing plus slot resolution, i.e. everything before execution.
+    results.push_back(measure("parser/parse_and_resolve_1mb", 1, [&](uint64_t) {
+        Program program = parseSource(src);
+        keep(program.statements.size());
+    }, src.size()));
+}
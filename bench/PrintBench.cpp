@@ -0,0 +1,70 @@
+#include "Bench.hpp"
+#include "Output.hpp"
+#include "Interpreter.hpp"
+#include "Runtime.hpp"
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr uint64_t Lines = 200000;
+
+const char* printLoop =
+    "FOR I = 1 TO 100000 {\n"
+    "    PRINT I;\n"
+    "    PRINT \"log line \" + I;\n"
+    "}\n";
+
+} // namespace
+
+void printBenchmarks(std::vector<BenchResult>& results) {
+    // What PRINT used to do for a number: stream it through iostreams.
+    results.push_back(measure("print/format_number_iostream", 2000000, [](uint64_t n) {
+        std::ostringstream out;
+        for (uint64_t i = 0; i < n; i++) {
+            out.str({});
+            out << (static_cast<double>(i) * 0.37);
+            keep(out.str().size());
+        }
+    }));
+
+    results.push_back(measure("print/format_number_to_chars", 2000000, [](uint64_t n) {
+        char text[NumberBufferSize];
+        for (uint64_t i = 0; i < n; i++)
+            keep(formatNumber(text, static_cast<double>(i) * 0.37));
+    }));
+
+    results.push_back(measure("print/parse_number_stod", 2000000, [](uint64_t n) {
+        std::string text = "12345.678";
+        for (uint64_t i = 0; i < n; i++)
+            keep(std::stod(text));
+    }));
+
+    results.push_back(measure("print/parse_number_from_chars", 2000000, [](uint64_t n) {
+        std::string_view text = "12345.678";
+        for (uint64_t i = 0; i < n; i++)
+            keep(parseNumber(text));
+    }));
+
+    std::FILE* sink = std::fopen(
+#ifdef _WIN32
+        "NUL",
+#else
+        "/dev/null",
+#endif
+        "w");
+    if (!sink) return;
+
+    Program program = parseSource(printLoop);
+    for (FlushPolicy p : {FlushPolicy::LINE, FlushPolicy::SIZE}) {
+        Interpreter vm({.out = sink, .flush = p});
+        const char* name = p == FlushPolicy::LINE ? "print/print_loop_flush_line" : "print/print_loop_flush_size";
+        results.push_back(measure(name, Lines, [&](uint64_t) {
+            vm.run(program);
+            vm.sync();
+        }));
+    }
+
+    std::fclose(sink);
+}
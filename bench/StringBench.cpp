@@ -0,0 +1,27 @@
+#include "Bench.hpp"
+#include "Interpreter.hpp"
+#include "Runtime.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+std::string reportLoop(int lines) {
+    return "SET OUT TO \"\";\n"
+           "FOR I = 1 TO " + std::to_string(lines) + " {\n"
+           "    SET OUT TO OUT + \"line \" + I + \" of the report\";\n"
+           "}\n"
+           "IF OUT::IS(\"\") THEN { }\n";
+}
+
+} // namespace
+
+void stringBenchmarks(std::vector<BenchResult>& results) {
+    Interpreter vm;
+    // ns/op should stay flat as the report grows if concatenation is linear.
+    for (int lines : {10000, 40000, 160000}) {
+        Program program = parseSource(reportLoop(lines));
+        results.push_back(measure("string/report_concat_" + std::to_string(lines), lines, [&](uint64_t) {
+            vm.run(program);
+        }));
+    }
+}
@@ -0,0 +1,72 @@
+#include "Bench.hpp"
+#include "Interpreter.hpp"
+#include "Runtime.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+// The pre-tagged-union layout of Value, kept here only as a baseline.
+struct LegacyValue {
+    ValueType type = ValueType::NOTHING;
+    double number = 0;
+    std::string string;
+    bool boolean = false;
+};
+
+struct LegacyVariable {
+    LegacyValue value;
+    bool isconstant = false;
+};
+
+LegacyValue legacyAdd(const LegacyValue& l, const LegacyValue& r) {
+    LegacyValue val;
+    val.type = ValueType::NUMBER;
+    val.number = l.number + r.number;
+    return val;
+}
+
+LegacyValue (*volatile legacyAddFn)(const LegacyValue&, const LegacyValue&) = legacyAdd;
+Value (*volatile addFn)(const Value&, const Value&) = addValues;
+
+const char* arithmeticLoop =
+    "SET T TO 0;\n"
+    "FOR I = 1 TO 1000000 {\n"
+    "    SET T TO T + I;\n"
+    "}\n";
+
+} // namespace
+
+void valueBenchmarks(std::vector<BenchResult>& results) {
+    std::printf("sizeof(Value)          %zu bytes (legacy layout %zu)\n", sizeof(Value), sizeof(LegacyValue));
+    std::printf("sizeof(Variable)       %zu bytes (legacy layout %zu)\n", sizeof(Variable), sizeof(LegacyVariable));
+
+    results.push_back(measure("value/add_number_legacy", 20000000, [](uint64_t n) {
+        LegacyValue acc;
+        acc.type = ValueType::NUMBER;
+        LegacyValue one;
+        one.type = ValueType::NUMBER;
+        one.number = 1;
+        for (uint64_t i = 0; i < n; i++)
+            acc = legacyAddFn(acc, one);
+        keep(acc.number);
+    }));
+
+    results.push_back(measure("value/add_number", 20000000, [](uint64_t n) {
+        Value acc(0.0);
+        Value one(1.0);
+        for (uint64_t i = 0; i < n; i++)
+            acc = addFn(acc, one);
+        keep(acc.number);
+    }));
+
+    Program program = parseSource(arithmeticLoop);
+    Interpreter vm;
+    Interpreter walker({.treeWalk = true});
+    results.push_back(measure("value/for_add_loop_vm", 1000000, [&](uint64_t) {
+        vm.run(program);
+    }));
+    results.push_back(measure("value/for_add_loop_tree_walk", 1000000, [&](uint64_t) {
+        walker.run(program);
+    }));
+}
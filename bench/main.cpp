@@ -0,0 +1,76 @@
+#include "Bench.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+void valueBenchmarks(std::vector<BenchResult>& results);
+void stringBenchmarks(std::vector<BenchResult>& results);
+void lexerBenchmarks(std::vector<BenchResult>& results);
+void parserBenchmarks(std::vector<BenchResult>& results);
+void evalBenchmarks(std::vector<BenchResult>& results);
+void ffiBenchmarks(std::vector<BenchResult>& results);
+void printBenchmarks(std::vector<BenchResult>& results);
+void parallelBenchmarks(std::vector<BenchResult>& results);
+void arrayBenchmarks(std::vector<BenchResult>& results);
+
+void writeJson(std::FILE* out, const std::vector<BenchResult>& results) {
+    std::fprintf(out, "{\n  \"version\": \"%s\",\n  \"repetitions\": %d,\n  \"results\": [",
+                 JORGESCRIPT_VERSION, benchOptions.repetitions);
+    const char* separator = "\n";
+    for (const BenchResult& r : results) {
+        std::fprintf(out, "%s    {\"name\": \"%s\", \"iterations\": %llu, \"bytes\": %llu, "
+                          "\"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, \"max_ns_per_op\": %.3f, "
+                          "\"ops_per_sec\": %.1f, \"mb_per_sec\": %.3f}",
+                     separator, r.name.c_str(),
+                     static_cast<unsigned long long>(r.iterations), static_cast<unsigned long long>(r.bytes),
+                     r.nsPerOp(), r.nsPerOp(r.minSeconds), r.nsPerOp(r.maxSeconds),
+                     r.opsPerSec(), r.mbPerSec());
+        separator = ",\n";
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+    const char* jsonPath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--filter") && i + 1 < argc)
+            benchOptions.filter = argv[++i];
+        else if (!std::strcmp(argv[i], "--repetitions") && i + 1 < argc)
+            benchOptions.repetitions = std::atoi(argv[++i]);
+        else {
+            std::fprintf(stderr, "Usage: jorgescript_bench [--filter <substring>] [--repetitions <n>] [--json <file>]\n");
+            return 1;
+        }
+    }
+
+    std::vector<BenchResult> all;
+    valueBenchmarks(all);
+    stringBenchmarks(all);
+    lexerBenchmarks(all);
+    parserBenchmarks(all);
+    evalBenchmarks(all);
+    ffiBenchmarks(all);
+    printBenchmarks(all);
+    parallelBenchmarks(all);
+    arrayBenchmarks(all);
+
+    std::vector<BenchResult> results;
+    for (BenchResult& r : all)
+        if (!r.skipped) results.push_back(std::move(r));
+
+    for (auto& r : results)
+        report(r);
+
+    if (jsonPath) {
+        std::FILE* out = std::fopen(jsonPath, "w");
+        if (!out) {
+            std::fprintf(stderr, "Cannot write %s\n", jsonPath);
+            return 1;
+        }
+        writeJson(out, results);
+        std::fclose(out);
+    }
+}
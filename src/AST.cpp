@@ -1,201 +1,215 @@
-#include "Lexer.hpp"
-#include "Parser.hpp"
 #include "AST.hpp"
+#include "Interpreter.hpp"
 #include "Runtime.hpp"
 #include <stdexcept>
-#include <fstream>
-#include <sstream>
 
-namespace {
-std::wstring utf8ToUtf16(const std::string& s) {
-    if (s.empty()) return {};
-    int size = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, nullptr, 0);
-    std::wstring result(size, 0);
-    MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, &result[0], size);
-    result.pop_back();
-    return result;
+void Value::drop() {
+    if (type == ValueType::STRING) string->release();
+    else array->release();
 }
 
-std::string readFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file)
-        throw std::runtime_error("Failed to open file: " + filename);
-
-    std::string content((std::istreambuf_iterator<char>(file)),
-                         std::istreambuf_iterator<char>());
-    return content;
+Value VariableExpr::evaluate(Interpreter& in) {
+    if (form == Form::LOCAL) {
+        const Variable& own = in.scopes.back().slots[slot];
+        if (own.defined) [[likely]] return own.value;
+        form = Form::GENERIC;
+        in.quickening.generic++;
+        in.quickening.guardFailures++;
+    } else if (form == Form::UNINITIALIZED) {
+        if (in.scopes.back().slots[slot].defined) {
+            form = Form::LOCAL;
+            in.quickening.localReads++;
+        } else {
+            form = Form::GENERIC;
+            in.quickening.generic++;
+        }
+    }
+    return in.loadVariable(slot, name);
 }
 
-} // namespace
+namespace {
+Value genericBinary(char op, const Value& l, const Value& r) {
+    if(op == '+')
+        return addValues(l, r);
+    else if(op == '=')
+        return equalValues(l, r);
+
+    throw std::runtime_error("Unsupported binary op");
+}
 
-Value VariableExpr::evaluate() {
-    Variable* v = findVariable(name);
-    if(!v) throw std::runtime_error("Undefined variable: " + name);
-    return v->value;
-}
-
-Value BinaryExpr::evaluate() {
-    Value l = left->evaluate();
-    Value r = right->evaluate();
-
-    if(op == '+') {
-        if(l.type == ValueType::STRING || r.type == ValueType::STRING) {
-            std::string ls = (l.type==ValueType::STRING) ? l.string :
-                             (l.type==ValueType::NUMBER) ? std::to_string(l.number) :
-                             (l.boolean ? "TRUE!" : "FALSE!");
-            std::string rs = (r.type==ValueType::STRING) ? r.string :
-                             (r.type==ValueType::NUMBER) ? std::to_string(r.number) :
-                             (r.boolean ? "TRUE!" : "FALSE!");
-            Value val;
-            val.type = ValueType::STRING;
-            val.string = ls + rs;
-            return val;
+BinaryExpr::Form specialize(Quickening& q, char op, const Value& l, const Value& r) {
+    using Form = BinaryExpr::Form;
+    if (op == '+') {
+        if (l.type == ValueType::NUMBER && r.type == ValueType::NUMBER) {
+            q.numberAdd++;
+            return Form::NUMBER_ADD;
         }
-        if(l.type==ValueType::NUMBER && r.type==ValueType::NUMBER) {
-            Value val;
-            val.type = ValueType::NUMBER;
-            val.number = l.number + r.number;
-            return val;
+        if (l.type == ValueType::STRING || r.type == ValueType::STRING) {
+            q.stringConcat++;
+            return Form::STRING_CONCAT;
         }
-        throw std::runtime_error("Invalid types for +");
-    }
-    else if(op == '=') {
-        Value val;
-        val.type = ValueType::BOOLEAN;
-        if(l.type != r.type) {
-            val.boolean = false;
-        } else if(l.type==ValueType::NUMBER) {
-            val.boolean = (l.number == r.number);
-        } else if(l.type==ValueType::STRING) {
-            val.boolean = (l.string == r.string);
-        } else if(l.type==ValueType::BOOLEAN) {
-            val.boolean = (l.boolean == r.boolean);
-        } else {
-            val.boolean = false;
+    } else if (op == '=' && l.type == r.type) {
+        if (l.type == ValueType::NUMBER) {
+            q.numberEquals++;
+            return Form::NUMBER_EQUALS;
+        }
+        if (l.type == ValueType::BOOLEAN) {
+            q.boolEquals++;
+            return Form::BOOL_EQUALS;
         }
-        return val;
     }
-
-    throw std::runtime_error("Unsupported binary op");
+    q.generic++;
+    return Form::GENERIC;
 }
 
-void SetStatement::execute() {
-    Value val = expr->evaluate();
+} // namespace
 
-    if (isLocal) {
-        auto& localScope = ScopeStack.back();
-        localScope[name] = {val, isconstant};
-        return;
+Value BinaryExpr::evaluate(Interpreter& in) {
+    Value l = left->evaluate(in);
+    Value r = right->evaluate(in);
+
+    switch (form) {
+        case Form::NUMBER_ADD:
+            if (l.type == ValueType::NUMBER && r.type == ValueType::NUMBER) [[likely]]
+                return Value(l.number + r.number);
+            break;
+        case Form::STRING_CONCAT:
+            if (l.type == ValueType::STRING || r.type == ValueType::STRING) [[likely]]
+                return concatValues(l, r);
+            break;
+        case Form::NUMBER_EQUALS:
+            if (l.type == ValueType::NUMBER && r.type == ValueType::NUMBER) [[likely]]
+                return Value(l.number == r.number);
+            break;
+        case Form::BOOL_EQUALS:
+            if (l.type == ValueType::BOOLEAN && r.type == ValueType::BOOLEAN) [[likely]]
+                return Value(l.boolean == r.boolean);
+            break;
+        case Form::UNINITIALIZED:
+            form = specialize(in.quickening, op, l, r);
+            return genericBinary(op, l, r);
+        case Form::GENERIC:
+            return genericBinary(op, l, r);
     }
 
-    for (auto it = ScopeStack.rbegin(); it != ScopeStack.rend(); ++it) {
-        auto found = it->find(name);
-        if (found != it->end()) {
-            if (found->second.isconstant)
-                throw std::runtime_error("Cannot modify constant: " + name);
-            found->second.value = val;
-            return;
-        }
-    }
+    form = Form::GENERIC;
+    in.quickening.generic++;
+    in.quickening.guardFailures++;
+    return genericBinary(op, l, r);
+}
+
+Value ArrayExpr::evaluate(Interpreter& in) {
+    if (size)
+        return zeros(size->evaluate(in));
 
-    ScopeStack.front()[name] = {val, isconstant};
+    std::vector<Value> values;
+    values.reserve(elements.size());
+    for (Expr* expr : elements)
+        values.push_back(expr->evaluate(in));
+    return arrayOf(values.data(), values.size());
 }
 
-void PrintStatement::execute() {
-    Value val = expr->evaluate();
-    switch(val.type){
-        case ValueType::STRING:  std::cout << val.string; break;
-        case ValueType::NUMBER:  std::cout << val.number; break;
-        case ValueType::BOOLEAN: std::cout << (val.boolean?"TRUE!":"Untrue..."); break;
-        case ValueType::NOTHING: std::cout << "NOTHING"; break;
-        default:                 std::cout << "IDK"; break;
-    }
-    std::cout << "\n";
+Value IndexExpr::evaluate(Interpreter& in) {
+    Value a = array->evaluate(in);
+    return elementOf(a, index->evaluate(in));
+}
+
+Value LengthExpr::evaluate(Interpreter& in) {
+    return lengthOf(value->evaluate(in));
 }
 
-void IfStatement::execute() {
-    Value cond = condition->evaluate();
+void SetStatement::execute(Interpreter& in) {
+    Value val = expr->evaluate(in);
+    in.assignVariable(slot, name, val, isconstant, isLocal);
+}
+
+void SetElementStatement::execute(Interpreter& in) {
+    Value i = index->evaluate(in);
+    in.storeElement(slot, name, i, expr->evaluate(in));
+}
+
+void PrintStatement::execute(Interpreter& in) {
+    in.print(expr->evaluate(in));
+}
+
+void IfStatement::execute(Interpreter& in) {
+    Value cond = condition->evaluate(in);
     if(cond.type != ValueType::BOOLEAN)
         throw std::runtime_error("IF condition must be boolean");
     if(cond.boolean) {
-        for(auto& stmt : body)
-            stmt->execute();
+        in.execute(body);
     }
 }
 
-void LoadDllStatement::execute() {
-    HMODULE mod = LoadLibraryA(dllName.c_str());
-    if (!mod)
-        throw std::runtime_error("Failed to load DLL: " + dllName);
-
-    LoadedDLLs[alias] = mod;
+void LoadDllStatement::execute(Interpreter& in) {
+    in.loadLibrary(dllName, alias);
 }
 
-void CallDllStatement::execute() {
-    auto it = LoadedDLLs.find(alias);
-    if (it == LoadedDLLs.end())
-        throw std::runtime_error("DLL not loaded: " + alias);
+Value CallDllExpr::evaluate(Interpreter& in) {
+    if (args.size() <= MaxFfiArgs) {
+        Value values[MaxFfiArgs];
+        for (size_t i = 0; i < args.size(); i++)
+            values[i] = args[i]->evaluate(in);
+        return in.callLibrary(*this, values, args.size());
+    }
 
-    FARPROC proc = GetProcAddress(it->second, function.c_str());
-    if (!proc)
-        throw std::runtime_error("Function not found: " + function);
+    std::vector<Value> values;
+    for (Expr* expr : args)
+        values.push_back(expr->evaluate(in));
+    return in.callLibrary(*this, values.data(), values.size());
+}
 
-    using StubFn = int(__stdcall*)(int, void**);
-    StubFn fn = reinterpret_cast<StubFn>(proc);
+void CallDllStatement::execute(Interpreter& in) {
+    call->evaluate(in);
+}
 
-    std::vector<void*> argsPtrs;
-    std::vector<std::wstring> wstrings;
-    std::vector<intptr_t> ints;
+void AsyncCallStatement::execute(Interpreter& in) {
+    NodeList<Expr*>& args = call->args;
+    std::vector<Value> values;
+    values.reserve(args.size());
+    for (Expr* expr : args)
+        values.push_back(expr->evaluate(in));
+    in.assignVariable(slot, name, Value(in.startCall(*call, values.data(), values.size())), false, true);
+}
 
-    for (auto& expr : args) {
-        Value v = expr->evaluate();
-        if (v.type == ValueType::NUMBER) {
-            ints.push_back(static_cast<intptr_t>(v.number));
-            argsPtrs.push_back(reinterpret_cast<void*>(ints.back()));
-        } else if (v.type == ValueType::BOOLEAN) {
-            ints.push_back(v.boolean ? 1 : 0);
-            argsPtrs.push_back(reinterpret_cast<void*>(ints.back()));
-        } else if (v.type == ValueType::STRING) {
-            wstrings.push_back(utf8ToUtf16(v.string));
-            argsPtrs.push_back((void*)wstrings.back().c_str());
-        } else {
-            throw std::runtime_error("Unsupported argument type");
-        }
-    }
+Value AwaitExpr::evaluate(Interpreter& in) {
+    return in.awaitCall(handle->evaluate(in));
+}
 
-    fn(static_cast<int>(argsPtrs.size()), argsPtrs.data());
+void AwaitStatement::execute(Interpreter& in) {
+    await->evaluate(in);
 }
 
-void SummonStatement::execute() {
-    std::string src = readFile(filename);
+void DeclareStatement::execute(Interpreter& in) {
+    in.declareFunction(*this);
+}
 
-    Lexer lexer(src);
-    Parser parser(lexer);
-    auto program = parser.parseProgram();
+void SummonStatement::execute(Interpreter& in) {
+    const Program& program = in.modules.get(filename).program;
 
-    ScopeStack.push_back({});
+    in.pushScope(program.slotNames);
 
-    for (auto& stmt : program)
-        stmt->execute();
+    if (in.profiler.enabled) in.profiler.pushFile(filename);
+    in.execute(program.statements);
+    if (in.profiler.enabled) in.profiler.popFile();
 
     if (!alias.empty()) {
-        FileScopes[alias] = ScopeStack.back();
+        in.fileScopes[std::string(alias)] = in.scopes.back();
     }
 
-    ScopeStack.pop_back();
+    in.popScope();
 }
 
-void WhileStatement::execute() {
-    while(condition->evaluate().boolean) {
-        for(auto& stmt : body)
-            stmt->execute();
+void WhileStatement::execute(Interpreter& in) {
+    while(condition->evaluate(in).isTrue()) {
+        in.execute(body);
     }
 }
 
-void ForStatement::execute() {
-    Value startVal = startExpr->evaluate();
-    Value endVal = endExpr->evaluate();
-    Value stepVal = stepExpr ? stepExpr->evaluate() : Value(1.0);
+void ForStatement::execute(Interpreter& in) {
+    Value startVal = startExpr->evaluate(in);
+    Value endVal = endExpr->evaluate(in);
+    Value stepVal = stepExpr ? stepExpr->evaluate(in) : Value(1.0);
 
     if(startVal.type != ValueType::NUMBER || endVal.type != ValueType::NUMBER || stepVal.type != ValueType::NUMBER)
         throw std::runtime_error("FOR loop bounds must be numbers");
@@ -204,14 +218,32 @@ void ForStatement::execute() {
     double end = endVal.number;
     double step = stepVal.number;
 
-    while ((step > 0 && i <= end) || (step < 0 && i >= end)) {
-        ScopeStack.back()[varName] = {Value(i), false};
+    if (step > 0) {
+        for (; i <= end; i += step) {
+            in.setLoopVariable(slot, i);
+            in.execute(body);
+        }
+    } else if (step < 0) {
+        for (; i >= end; i += step) {
+            in.setLoopVariable(slot, i);
+            in.execute(body);
+        }
+    }
 
-        for(auto& stmt : body)
-            stmt->execute();
+    in.eraseLoopVariable(slot);
+}
 
-        i += step;
-    }
+void ParallelForStatement::execute(Interpreter& in) {
+    Value startVal = startExpr->evaluate(in);
+    Value endVal = endExpr->evaluate(in);
+    Value stepVal = stepExpr ? stepExpr->evaluate(in) : Value(1.0);
+    in.runParallel(*this, startVal, endVal, stepVal);
+}
 
-    ScopeStack.back().erase(varName);
+Value CallExpr::evaluate(Interpreter& in) {
+    in.output.write("CallExpr: ");
+    in.output.write(function);
+    in.output.write("()");
+    in.output.endLine();
+    return Value();
 }
@@ -1,120 +1,472 @@
 #pragma once
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <iostream>
 
+#include "Arena.hpp"
+#include "Library.hpp"
+#include "NumArray.hpp"
+#include "Output.hpp"
+#include "Rope.hpp"
+
 struct Expr;
 struct Statement;
+struct LiteralExpr;
+class Compiler;
+class Resolver;
+class CacheWriter;
+class Optimizer;
+class AstPrinter;
+class Interpreter;
+
+// Hash for maps keyed by std::string that are looked up with the
+// string_views stored in AST nodes.
+struct NameHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
 
-enum class ValueType { NOTHING, NUMBER, STRING, BOOLEAN, IDK };
+template <typename T>
+using NameMap = std::unordered_map<std::string, T, NameHash, std::equal_to<>>;
 
+enum class ValueType : uint8_t { NOTHING, NUMBER, STRING, BOOLEAN, IDK, ARRAY };
+
+// 16 bytes: a one-byte tag and an 8-byte payload. Numbers and booleans are
+// stored inline, strings are a shared reference to an immutable Rope and
+// arrays one to a NumArray.
 struct Value {
     ValueType type = ValueType::NOTHING;
-    double number = 0;
-    std::string string;
-    bool boolean = false;
+    union {
+        double number;
+        bool boolean;
+        Rope* string;
+        NumArray* array;
+    };
+
+    Value() : number(0) {}
 
-    Value() : type(ValueType::NOTHING) {}
-    
     Value(double n) : type(ValueType::NUMBER), number(n) {}
-    Value(const std::string& s) : type(ValueType::STRING), string(s) {}
-    Value(bool b) : type(ValueType::BOOLEAN), boolean(b) {}
+    Value(std::string s) : type(ValueType::STRING), string(Rope::leaf(std::move(s))) {}
+    Value(const char* s) : Value(std::string(s)) {}
+    Value(bool b) : type(ValueType::BOOLEAN), number(0) { boolean = b; }
+    // Adopts the caller's reference.
+    explicit Value(Rope* rope) : type(ValueType::STRING), string(rope) {}
+    explicit Value(NumArray* elements) : type(ValueType::ARRAY), array(elements) {}
+
+    Value(const Value& other) : type(other.type), number(other.number) {
+        if (type == ValueType::STRING) string->retain();
+        else if (type == ValueType::ARRAY) array->retain();
+    }
+    Value(Value&& other) noexcept : type(other.type), number(other.number) {
+        other.type = ValueType::NOTHING;
+    }
+    Value& operator=(const Value& other) {
+        if (this != &other) {
+            Value copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+    Value& operator=(Value&& other) noexcept {
+        Value moved(std::move(other));
+        swap(moved);
+        return *this;
+    }
+    // Numbers and booleans hold nothing to release; only the reference
+    // drop is out of line, so the check inlines into the VM's dispatch loop.
+    ~Value() {
+        if (type == ValueType::STRING || type == ValueType::ARRAY) [[unlikely]] drop();
+    }
+
+    void swap(Value& other) noexcept {
+        std::swap(type, other.type);
+        std::swap(number, other.number);
+    }
+
+    const std::string& str() const { return string->flat(); }
+    bool isTrue() const { return type == ValueType::BOOLEAN && boolean; }
+
+private:
+    void drop();
 };
 
+static_assert(sizeof(Value) == 16, "Value should stay a 16-byte tagged union");
+
 struct Variable {
     Value value;
     bool isconstant = false;
+    bool defined = false;
 };
 
+// Nodes live in the Program's Arena and are never deleted individually, so
+// they hold only trivially destructible members: names are views of text
+// copied into the arena and child lists are arena arrays.
 struct Expr {
-    virtual ~Expr() = default;
-    virtual Value evaluate() = 0;
+    virtual Value evaluate(Interpreter& in) = 0;
+    virtual void compile(Compiler& c) = 0;
+    virtual void resolve(Resolver&) {}
+    virtual void serialize(CacheWriter& w) = 0;
+    // Returns the expression to use in place of this one.
+    virtual Expr* fold(Optimizer&) { return this; }
+    virtual LiteralExpr* asLiteral() { return nullptr; }
+    virtual void dump(AstPrinter& p) = 0;
 };
 
 struct LiteralExpr : Expr {
     Value value;
-    Value evaluate() override { return value; }
+    Value evaluate(Interpreter&) override { return value; }
+    void compile(Compiler& c) override;
+    void serialize(CacheWriter& w) override;
+    LiteralExpr* asLiteral() override { return this; }
+    void dump(AstPrinter& p) override;
+};
+
+// Counts of the rewrites the tree walker made to quickened nodes (--stats).
+struct Quickening {
+    uint64_t numberAdd = 0;
+    uint64_t stringConcat = 0;
+    uint64_t numberEquals = 0;
+    uint64_t boolEquals = 0;
+    uint64_t localReads = 0;
+    // Nodes rewritten to their generic form, either on the first evaluation
+    // or when a specialised form's guard failed (also in guardFailures).
+    uint64_t generic = 0;
+    uint64_t guardFailures = 0;
 };
 
 struct VariableExpr : Expr {
-    std::string name;
-    Value evaluate();
+    // LOCAL once a read found the variable in the frame's own slot; a later
+    // read that does not falls back to GENERIC, the name-based search through
+    // the callers' frames.
+    enum class Form : uint8_t { UNINITIALIZED, LOCAL, GENERIC };
+
+    std::string_view name;
+    uint32_t slot = 0;
+    Form form = Form::UNINITIALIZED;
+    Value evaluate(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    Expr* fold(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
 };
 
 struct BinaryExpr : Expr {
-    std::unique_ptr<Expr> left;
-    std::unique_ptr<Expr> right;
+    // The first evaluation rewrites the node into the form for the operand
+    // types it saw. Each form only checks those types and rewrites itself to
+    // GENERIC, which dispatches on `op` and both types, when they differ.
+    enum class Form : uint8_t { UNINITIALIZED, NUMBER_ADD, STRING_CONCAT, NUMBER_EQUALS, BOOL_EQUALS, GENERIC };
+
+    Expr* left = nullptr;
+    Expr* right = nullptr;
     char op;
-    Value evaluate() override;
+    Form form = Form::UNINITIALIZED;
+    Value evaluate(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    Expr* fold(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
+};
+
+// `[1, 2, 3]`, or `ARRAY(n)` for n zeros when `size` is set.
+struct ArrayExpr : Expr {
+    NodeList<Expr*> elements;
+    Expr* size = nullptr;
+    Value evaluate(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    Expr* fold(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
+};
+
+// `A[I]`: element I of array A, counting from 1.
+struct IndexExpr : Expr {
+    Expr* array = nullptr;
+    Expr* index = nullptr;
+    Value evaluate(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    Expr* fold(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
+};
+
+// `LENGTH(A)` of an array or a string.
+struct LengthExpr : Expr {
+    Expr* value = nullptr;
+    Value evaluate(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    Expr* fold(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
 };
 
 struct Statement {
-    virtual ~Statement() = default;
-    virtual void execute() = 0;
+    // 1-based position of the statement's first token in its script.
+    uint32_t line = 0;
+    uint32_t column = 0;
+
+    virtual const char* kind() const = 0;
+    virtual void execute(Interpreter& in) = 0;
+    virtual void compile(Compiler& c) = 0;
+    virtual void resolve(Resolver&) {}
+    virtual void serialize(CacheWriter& w) = 0;
+    // Records what the statement assigns before the Optimizer rewrites it.
+    virtual void collect(Optimizer&) {}
+    // Hands the Optimizer the statements that replace this one.
+    virtual void optimize(Optimizer& o);
+    virtual void dump(AstPrinter& p) = 0;
 };
 
+using StatementList = NodeList<Statement*>;
+
 struct SetStatement : Statement {
-    std::string name;
-    std::unique_ptr<Expr> expr;
+    std::string_view name;
+    Expr* expr = nullptr;
     bool isconstant = false;
     bool isLocal = false;
-    void execute() override;
+    uint32_t slot = 0;
+    const char* kind() const override { return "SET"; }
+    void execute(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    void collect(Optimizer& o) override;
+    void optimize(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
+};
+
+// `SET A[I] TO x;` writes one element of the array A holds, in place
+// unless another value shares that array.
+struct SetElementStatement : Statement {
+    std::string_view name;
+    uint32_t slot = 0;
+    Expr* index = nullptr;
+    Expr* expr = nullptr;
+    const char* kind() const override { return "SET"; }
+    void execute(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    void collect(Optimizer& o) override;
+    void optimize(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
 };
 
 struct PrintStatement : Statement {
-    std::unique_ptr<Expr> expr;
-    void execute() override;
+    Expr* expr = nullptr;
+    const char* kind() const override { return "PRINT"; }
+    void execute(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    void optimize(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
 };
 
 struct IfStatement : Statement {
-    std::unique_ptr<Expr> condition;
-    std::vector<std::unique_ptr<Statement>> body;
-    void execute() override;
+    Expr* condition = nullptr;
+    StatementList body;
+    const char* kind() const override { return "IF"; }
+    void execute(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    void collect(Optimizer& o) override;
+    void optimize(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
 };
 
 struct LoadDllStatement : Statement {
-    std::string dllName;
-    std::string alias;
-    void execute() override;
+    std::string_view dllName;
+    std::string_view alias;
+    const char* kind() const override { return "LOADDLL"; }
+    void execute(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void serialize(CacheWriter& w) override;
+    void dump(AstPrinter& p) override;
 };
 
+// The function a CALL resolved to the last time it ran, with the signature
+// DECLAREd for it (if any) and room to marshal its arguments. It is only
+// reused while no LOADDLL or DECLARE has run since, as either may have
+// rebound the alias or changed the signature.
+struct CallSite {
+    void* fn = nullptr;
+    const FfiSignature* signature = nullptr;
+    uint64_t generation = 0;
+    FfiSlot args[MaxFfiArgs];
+};
+
+struct CallDllExpr : Expr {
+    std::string_view alias;
+    std::string_view function;
+    NodeList<Expr*> args;
+    CallSite site;
+    Value evaluate(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    Expr* fold(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
+};
+
+// `CALL ALIAS::fn(...);` with the result discarded.
 struct CallDllStatement : Statement {
-    std::string alias;
-    std::string function;
-    std::vector<std::unique_ptr<Expr>> args;
-    void execute() override;
+    CallDllExpr* call = nullptr;
+    const char* kind() const override { return "CALL"; }
+    void execute(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    void optimize(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
+};
+
+// `ASYNC CALL ALIAS::fn(...) AS H;` starts the call on another thread and
+// binds H, like INSIDE SET, to a handle for AWAIT.
+struct AsyncCallStatement : Statement {
+    CallDllExpr* call = nullptr;
+    std::string_view name;
+    uint32_t slot = 0;
+    const char* kind() const override { return "ASYNC CALL"; }
+    void execute(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    void collect(Optimizer& o) override;
+    void optimize(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
+};
+
+// `AWAIT H`: the result of the ASYNC CALL behind handle H, once it is back.
+struct AwaitExpr : Expr {
+    Expr* handle = nullptr;
+    Value evaluate(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    Expr* fold(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
+};
+
+// `AWAIT H;` with the result discarded.
+struct AwaitStatement : Statement {
+    AwaitExpr* await = nullptr;
+    const char* kind() const override { return "AWAIT"; }
+    void execute(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    void optimize(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
+};
+
+// `DECLARE ALIAS::fn(TYPE, ...) AS TYPE;`
+struct DeclareStatement : Statement {
+    std::string_view alias;
+    std::string_view function;
+    FfiType returnType = FfiType::VOID;
+    NodeList<FfiType> argTypes;
+    const char* kind() const override { return "DECLARE"; }
+    void execute(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void serialize(CacheWriter& w) override;
+    void dump(AstPrinter& p) override;
 };
 
 struct SummonStatement : Statement {
-    std::string filename;
-    std::string alias;
-    void execute() override;
+    std::string_view filename;
+    std::string_view alias;
+    const char* kind() const override { return "SUMMON"; }
+    void execute(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    void collect(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
 };
 
 struct WhileStatement : Statement {
-    std::unique_ptr<Expr> condition;
-    std::vector<std::unique_ptr<Statement>> body;
-    void execute() override;
+    Expr* condition = nullptr;
+    StatementList body;
+    const char* kind() const override { return "WHILE"; }
+    void execute(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    void collect(Optimizer& o) override;
+    void optimize(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
 };
 
 struct ForStatement : Statement {
-    std::string varName;
-    std::unique_ptr<Expr> startExpr;
-    std::unique_ptr<Expr> endExpr;
-    std::unique_ptr<Expr> stepExpr;
-    std::vector<std::unique_ptr<Statement>> body;
-    void execute() override;
+    std::string_view varName;
+    uint32_t slot = 0;
+    // Set by the Resolver when nothing in the body can assign the variable
+    // (no SET of it, no inner FOR over it, no SUMMON), so the VM reads the
+    // loop counter itself instead of storing it into the frame.
+    bool counted = false;
+    Expr* startExpr = nullptr;
+    Expr* endExpr = nullptr;
+    Expr* stepExpr = nullptr;
+    StatementList body;
+    const char* kind() const override { return "FOR"; }
+    void execute(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    void collect(Optimizer& o) override;
+    void optimize(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
+};
+
+// `PARALLEL FOR I = A TO B [STEP S] [REDUCE X, Y] { ... }`: the range is
+// cut into pieces that run on separate threads (Interpreter::runParallel).
+// The body sees a private copy of every frame; it may only SET its INSIDE
+// locals and the REDUCE variables, whose per-piece results are added to
+// the outer value with `+` in loop order.
+struct ParallelForStatement : Statement {
+    std::string_view varName;
+    uint32_t slot = 0;
+    Expr* startExpr = nullptr;
+    Expr* endExpr = nullptr;
+    Expr* stepExpr = nullptr;
+    NodeList<std::string_view> reductions;
+    StatementList body;
+    const char* kind() const override { return "PARALLEL FOR"; }
+    void execute(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void resolve(Resolver& r) override;
+    void serialize(CacheWriter& w) override;
+    void collect(Optimizer& o) override;
+    void optimize(Optimizer& o) override;
+    void dump(AstPrinter& p) override;
 };
 
 struct CallExpr : Expr {
-    std::unique_ptr<Expr> object;
-    std::string function;
-    std::vector<std::unique_ptr<Expr>> args;
+    Expr* object = nullptr;
+    std::string_view function;
+    NodeList<Expr*> args;
 
-    Value evaluate() override {
-        std::cout << "CallExpr: " << function << "()" << std::endl;
-        return Value();
-    }
-};
\ No newline at end of file
+    Value evaluate(Interpreter& in) override;
+    void compile(Compiler& c) override;
+    void serialize(CacheWriter& w) override;
+    void dump(AstPrinter& p) override;
+};
+
+// A parsed script together with the arena that owns all of its nodes.
+struct Program {
+    Arena arena;
+    StatementList statements;
+    std::vector<std::string> slotNames;
+    // File names of every SUMMON in the program, reachable or not.
+    std::vector<std::string_view> imports;
+};
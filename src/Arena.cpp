@@ -0,0 +1,93 @@
+#include "Arena.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+constexpr size_t MaxBlockSize = 4 * 1024 * 1024;
+
+size_t alignUp(size_t value, size_t align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+} // namespace
+
+Arena::~Arena() {
+    release();
+}
+
+Arena::Arena(Arena&& other) noexcept
+    : blocks(std::exchange(other.blocks, nullptr)),
+      cursor(std::exchange(other.cursor, nullptr)),
+      limit(std::exchange(other.limit, nullptr)),
+      finalizers(std::exchange(other.finalizers, nullptr)),
+      nextBlockSize(other.nextBlockSize),
+      allocated(std::exchange(other.allocated, 0)) {}
+
+Arena& Arena::operator=(Arena&& other) noexcept {
+    if (this != &other) {
+        release();
+        blocks = std::exchange(other.blocks, nullptr);
+        cursor = std::exchange(other.cursor, nullptr);
+        limit = std::exchange(other.limit, nullptr);
+        finalizers = std::exchange(other.finalizers, nullptr);
+        nextBlockSize = other.nextBlockSize;
+        allocated = std::exchange(other.allocated, 0);
+    }
+    return *this;
+}
+
+void* Arena::allocate(size_t size, size_t align) {
+    uintptr_t at = alignUp(reinterpret_cast<uintptr_t>(cursor), align);
+    if (!cursor || at + size > reinterpret_cast<uintptr_t>(limit)) {
+        grow(size + align);
+        at = alignUp(reinterpret_cast<uintptr_t>(cursor), align);
+    }
+
+    cursor = reinterpret_cast<char*>(at + size);
+    allocated += size;
+    return reinterpret_cast<void*>(at);
+}
+
+std::string_view Arena::copy(std::string_view text) {
+    char* out = static_cast<char*>(allocate(text.size() + 1, 1));
+    if (!text.empty())
+        std::memcpy(out, text.data(), text.size());
+    out[text.size()] = '\0';
+    return {out, text.size()};
+}
+
+void Arena::addFinalizer(void* object, void (*destroy)(void*)) {
+    Finalizer* f = static_cast<Finalizer*>(allocate(sizeof(Finalizer), alignof(Finalizer)));
+    f->destroy = destroy;
+    f->object = object;
+    f->next = finalizers;
+    finalizers = f;
+}
+
+void Arena::grow(size_t minimum) {
+    size_t size = std::max(nextBlockSize, alignUp(minimum + sizeof(Block), alignof(std::max_align_t)));
+    nextBlockSize = std::min(nextBlockSize * 2, MaxBlockSize);
+
+    Block* block = static_cast<Block*>(std::malloc(size));
+    if (!block) throw std::bad_alloc();
+    block->next = blocks;
+    block->size = size;
+    blocks = block;
+
+    cursor = reinterpret_cast<char*>(block) + alignUp(sizeof(Block), alignof(std::max_align_t));
+    limit = reinterpret_cast<char*>(block) + size;
+}
+
+void Arena::release() {
+    for (Finalizer* f = finalizers; f; f = f->next)
+        f->destroy(f->object);
+    finalizers = nullptr;
+
+    while (blocks) {
+        Block* next = blocks->next;
+        std::free(blocks);
+        blocks = next;
+    }
+    cursor = limit = nullptr;
+}
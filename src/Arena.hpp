@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Fixed-size array of nodes stored in an Arena.
+template <typename T>
+struct NodeList {
+    T* items = nullptr;
+    uint32_t count = 0;
+
+    T* begin() const { return items; }
+    T* end() const { return items + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t i) const { return items[i]; }
+};
+
+// Monotonic bump allocator that owns every node of one parsed program.
+// Memory is handed out in parse order from a few large blocks and released
+// all at once. Only objects that are not trivially destructible (literal
+// Values holding a string) register a destructor to run on teardown.
+class Arena {
+public:
+    Arena() = default;
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&& other) noexcept;
+    Arena& operator=(Arena&& other) noexcept;
+
+    void* allocate(size_t size, size_t align);
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            addFinalizer(object, [](void* o) { static_cast<T*>(o)->~T(); });
+        return object;
+    }
+
+    template <typename T>
+    NodeList<T> list(const T* items, size_t count) {
+        static_assert(std::is_trivially_copyable_v<T>, "NodeList items are copied bytewise");
+        NodeList<T> out;
+        if (count == 0) return out;
+        out.items = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        for (size_t i = 0; i < count; i++)
+            out.items[i] = items[i];
+        out.count = static_cast<uint32_t>(count);
+        return out;
+    }
+
+    // The copy is NUL-terminated so it can be handed to C APIs as is.
+    std::string_view copy(std::string_view text);
+
+    size_t bytesAllocated() const { return allocated; }
+
+private:
+    struct Block {
+        Block* next;
+        size_t size;
+    };
+
+    struct Finalizer {
+        void (*destroy)(void*);
+        void* object;
+        Finalizer* next;
+    };
+
+    void addFinalizer(void* object, void (*destroy)(void*));
+    void grow(size_t minimum);
+    void release();
+
+    Block* blocks = nullptr;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    Finalizer* finalizers = nullptr;
+    size_t nextBlockSize = 16 * 1024;
+    size_t allocated = 0;
+};
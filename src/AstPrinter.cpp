@@ -0,0 +1,207 @@
+#include "AstPrinter.hpp"
+#include <cstdio>
+#include <ostream>
+#include <string>
+
+namespace {
+const char* const FfiTypeNames[] = {"VOID", "BOOL", "INT", "INT64", "DOUBLE", "PTR", "STRING"};
+
+void dumpArgs(AstPrinter& p, const NodeList<Expr*>& args) {
+    p.out << '(';
+    for (size_t i = 0; i < args.size(); i++) {
+        if (i) p.out << ", ";
+        args[i]->dump(p);
+    }
+    p.out << ')';
+}
+
+} // namespace
+
+void AstPrinter::block(const StatementList& body) {
+    depth++;
+    for (Statement* stmt : body)
+        stmt->dump(*this);
+    depth--;
+}
+
+std::ostream& AstPrinter::begin(const Statement& stmt) {
+    char position[32];
+    std::snprintf(position, sizeof(position), "%5u:%-4u", stmt.line, stmt.column);
+    out << position << std::string((depth - 1) * 4, ' ');
+    return out;
+}
+
+void AstPrinter::end() {
+    out << std::string(10 + (depth - 1) * 4, ' ') << "}\n";
+}
+
+void LiteralExpr::dump(AstPrinter& p) {
+    switch (value.type) {
+        case ValueType::STRING: p.out << '"' << value.str() << '"'; break;
+        case ValueType::NUMBER: {
+            char text[NumberBufferSize];
+            p.out << std::string_view(text, formatNumber(text, value.number));
+            break;
+        }
+        case ValueType::BOOLEAN: p.out << (value.boolean ? "TRUE!" : "Untrue..."); break;
+        default: p.out << "NOTHING"; break;
+    }
+}
+
+void VariableExpr::dump(AstPrinter& p) {
+    p.out << name;
+}
+
+void BinaryExpr::dump(AstPrinter& p) {
+    p.out << '(';
+    left->dump(p);
+    p.out << ' ' << op << ' ';
+    right->dump(p);
+    p.out << ')';
+}
+
+void ArrayExpr::dump(AstPrinter& p) {
+    if (size) {
+        p.out << "ARRAY(";
+        size->dump(p);
+        p.out << ')';
+        return;
+    }
+    p.out << '[';
+    for (size_t i = 0; i < elements.size(); i++) {
+        if (i) p.out << ", ";
+        elements[i]->dump(p);
+    }
+    p.out << ']';
+}
+
+void IndexExpr::dump(AstPrinter& p) {
+    array->dump(p);
+    p.out << '[';
+    index->dump(p);
+    p.out << ']';
+}
+
+void LengthExpr::dump(AstPrinter& p) {
+    p.out << "LENGTH(";
+    value->dump(p);
+    p.out << ')';
+}
+
+void CallDllExpr::dump(AstPrinter& p) {
+    p.out << "CALL " << alias << "::" << function;
+    dumpArgs(p, args);
+}
+
+void CallExpr::dump(AstPrinter& p) {
+    object->dump(p);
+    p.out << "::" << function;
+    dumpArgs(p, args);
+}
+
+void SetStatement::dump(AstPrinter& p) {
+    p.begin(*this) << (isLocal ? "INSIDE " : "") << (isconstant ? "ALWAYS " : "") << "SET " << name << " TO ";
+    expr->dump(p);
+    p.out << ";\n";
+}
+
+void SetElementStatement::dump(AstPrinter& p) {
+    p.begin(*this) << "SET " << name << '[';
+    index->dump(p);
+    p.out << "] TO ";
+    expr->dump(p);
+    p.out << ";\n";
+}
+
+void PrintStatement::dump(AstPrinter& p) {
+    p.begin(*this) << "PRINT ";
+    expr->dump(p);
+    p.out << ";\n";
+}
+
+void IfStatement::dump(AstPrinter& p) {
+    p.begin(*this) << "IF ";
+    condition->dump(p);
+    p.out << " THEN {\n";
+    p.block(body);
+    p.end();
+}
+
+void LoadDllStatement::dump(AstPrinter& p) {
+    p.begin(*this) << "LOADDLL \"" << dllName << "\" AS " << alias << ";\n";
+}
+
+void CallDllStatement::dump(AstPrinter& p) {
+    p.begin(*this);
+    call->dump(p);
+    p.out << ";\n";
+}
+
+void AsyncCallStatement::dump(AstPrinter& p) {
+    p.begin(*this) << "ASYNC ";
+    call->dump(p);
+    p.out << " AS " << name << ";\n";
+}
+
+void AwaitExpr::dump(AstPrinter& p) {
+    p.out << "AWAIT ";
+    handle->dump(p);
+}
+
+void AwaitStatement::dump(AstPrinter& p) {
+    p.begin(*this);
+    await->dump(p);
+    p.out << ";\n";
+}
+
+void DeclareStatement::dump(AstPrinter& p) {
+    p.begin(*this) << "DECLARE " << alias << "::" << function << '(';
+    for (size_t i = 0; i < argTypes.size(); i++)
+        p.out << (i ? ", " : "") << FfiTypeNames[static_cast<size_t>(argTypes[i])];
+    p.out << ") AS " << FfiTypeNames[static_cast<size_t>(returnType)] << ";\n";
+}
+
+void SummonStatement::dump(AstPrinter& p) {
+    p.begin(*this) << "SUMMON \"" << filename << '"';
+    if (!alias.empty())
+        p.out << " AS " << alias;
+    p.out << ";\n";
+}
+
+void WhileStatement::dump(AstPrinter& p) {
+    p.begin(*this) << "WHILE ";
+    condition->dump(p);
+    p.out << " {\n";
+    p.block(body);
+    p.end();
+}
+
+void ForStatement::dump(AstPrinter& p) {
+    p.begin(*this) << "FOR " << varName << " = ";
+    startExpr->dump(p);
+    p.out << " TO ";
+    endExpr->dump(p);
+    if (stepExpr) {
+        p.out << " STEP ";
+        stepExpr->dump(p);
+    }
+    p.out << " {\n";
+    p.block(body);
+    p.end();
+}
+
+void ParallelForStatement::dump(AstPrinter& p) {
+    p.begin(*this) << "PARALLEL FOR " << varName << " = ";
+    startExpr->dump(p);
+    p.out << " TO ";
+    endExpr->dump(p);
+    if (stepExpr) {
+        p.out << " STEP ";
+        stepExpr->dump(p);
+    }
+    for (size_t i = 0; i < reductions.size(); i++)
+        p.out << (i ? ", " : " REDUCE ") << reductions[i];
+    p.out << " {\n";
+    p.block(body);
+    p.end();
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <iosfwd>
+
+#include "AST.hpp"
+
+// Prints a tree in a JorgeScript-like notation for --dump-ast, one
+// statement per line prefixed with its line:column.
+class AstPrinter {
+public:
+    explicit AstPrinter(std::ostream& out) : out(out) {}
+
+    void block(const StatementList& body);
+    // Starts the line of `stmt`; the node writes the rest.
+    std::ostream& begin(const Statement& stmt);
+    // Closes a block opened on the line of the enclosing statement.
+    void end();
+
+    std::ostream& out;
+
+private:
+    int depth = 0;
+};
@@ -0,0 +1,62 @@
+#include "Async.hpp"
+#include "Interpreter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+// Slow foreign routines often wait (on disk, on a lock, on a child
+// process) rather than compute, so a few of them may overlap even on a
+// single core. --threads is for PARALLEL FOR and does not size this pool.
+constexpr unsigned MinCallThreads = 4;
+} // namespace
+
+void EventLoop::post(std::coroutine_handle<> h) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.push_back(h);
+    }
+    posted.notify_one();
+}
+
+AsyncCall runForeign(EventLoop& loop, ThreadPool& pool, ForeignCall call) {
+    co_await EventLoop::offload(pool);
+    call.invoke();
+    co_await loop.back();
+    co_return call.result();
+}
+
+double Interpreter::startCall(CallDllExpr& call, const Value* args, size_t argc) {
+    ForeignCall prepared = prepareCall(call, args, argc);
+    if (!callPool)
+        callPool = std::make_unique<ThreadPool>(std::max(MinCallThreads, std::thread::hardware_concurrency()));
+
+    uint64_t handle = ++lastHandle;
+    asyncCalls.emplace(handle, runForeign(events, *callPool, std::move(prepared)));
+    return static_cast<double>(handle);
+}
+
+Value Interpreter::awaitCall(const Value& handle) {
+    bool valid = handle.type == ValueType::NUMBER && handle.number >= 1 &&
+                 handle.number <= static_cast<double>(lastHandle) &&
+                 handle.number == std::floor(handle.number);
+    auto it = valid ? asyncCalls.find(static_cast<uint64_t>(handle.number)) : asyncCalls.end();
+    if (it == asyncCalls.end())
+        throw std::runtime_error("AWAIT of something that is not a pending ASYNC CALL");
+
+    AsyncCall pending = std::move(it->second);
+    asyncCalls.erase(it);
+    events.run([&] { return pending.done(); });
+    return pending.take();
+}
+
+void Interpreter::finishCalls() {
+    events.run([this] {
+        for (const auto& [handle, pending] : asyncCalls)
+            if (!pending.done()) return false;
+        return true;
+    });
+    asyncCalls.clear();
+}
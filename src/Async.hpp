@@ -0,0 +1,129 @@
+#pragma once
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AST.hpp"
+#include "Library.hpp"
+#include "ThreadPool.hpp"
+
+// A foreign call made ready on the interpreter's thread so it can run on
+// another: string arguments are copies it owns, arrays are shared, and a
+// string the function returns is copied before the result goes back.
+struct ForeignCall {
+    void* fn = nullptr;
+    // DECLAREd calls go through the signature's trampoline, the others
+    // through the untyped (argc, argv) convention.
+    bool typed = false;
+    FfiSignature signature;
+    FfiSlot args[MaxFfiArgs];
+    std::vector<void*> argv;
+    // Reserved up front, so the pointers passed never move.
+    std::vector<std::string> strings;
+#ifdef _WIN32
+    std::vector<std::wstring> wide;
+#endif
+    // Arrays are passed in place; these references keep them alive. They
+    // are taken and dropped on the interpreter's thread.
+    std::vector<Value> arrays;
+    FfiSlot ret{};
+    std::string text;
+
+    // The part that may run on any thread.
+    void invoke();
+    // The result as a Value, on the interpreter's thread.
+    Value result() const;
+};
+
+// The one thread allowed to touch a script's state. A coroutine that went
+// to another thread comes back with `co_await loop.back()`, which queues
+// it; only run() on the interpreter's thread resumes queued coroutines, so
+// it happens while the script waits in AWAIT and nowhere else.
+class EventLoop {
+public:
+    struct Offload {
+        ThreadPool& pool;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { pool.submit([h] { h.resume(); }); }
+        void await_resume() const noexcept {}
+    };
+
+    struct Return {
+        EventLoop& loop;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { loop.post(h); }
+        void await_resume() const noexcept {}
+    };
+
+    // Continue on a thread of `pool`.
+    static Offload offload(ThreadPool& pool) { return {pool}; }
+    // Continue on the loop's thread, the next time it runs.
+    Return back() { return {*this}; }
+
+    void post(std::coroutine_handle<> h);
+
+    // Resumes queued coroutines until `done()`, sleeping while none is.
+    template <typename Done>
+    void run(Done done) {
+        while (!done()) {
+            std::coroutine_handle<> h;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                posted.wait(lock, [this] { return !ready.empty(); });
+                h = ready.front();
+                ready.pop_front();
+            }
+            h.resume();
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable posted;
+    std::deque<std::coroutine_handle<>> ready;
+};
+
+// An ASYNC CALL in flight: a coroutine that runs eagerly up to its first
+// suspension and ends suspended, so its frame (which owns the call's
+// arguments) lives until the AsyncCall is destroyed. Only destroy one that
+// is done().
+class AsyncCall {
+public:
+    struct promise_type {
+        Value result;
+        std::exception_ptr error;
+
+        AsyncCall get_return_object() {
+            return AsyncCall(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_value(Value v) { result = std::move(v); }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    explicit AsyncCall(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    AsyncCall(AsyncCall&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    AsyncCall& operator=(AsyncCall&&) = delete;
+    ~AsyncCall() {
+        if (handle) handle.destroy();
+    }
+
+    bool done() const { return handle.done(); }
+
+    Value take() {
+        if (handle.promise().error) std::rethrow_exception(handle.promise().error);
+        return std::move(handle.promise().result);
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Runs `call` on `pool` and finishes it on `loop`.
+AsyncCall runForeign(EventLoop& loop, ThreadPool& pool, ForeignCall call);
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AST.hpp"
+
+enum class OpCode : uint8_t {
+    CONSTANT,       // push constants[a]
+    LOAD,           // push variable in frame slot a
+    LOAD_COUNTER,   // push the counter of the counted FOR whose state is at stack[b]
+    STORE,          // pop into frame slot a, flags = STORE_CONSTANT | STORE_LOCAL
+    STORE_ELEMENT,  // pop value and index, write them into the array in frame slot a
+    ADD,
+    EQUAL,
+    ARRAY_OF,       // pop b numbers, push an array of them
+    ZEROS,          // pop a length, push an array of that many zeros
+    INDEX,          // pop index and array, push the element
+    LENGTH,         // replace the top with its length
+    PRINT,
+    JUMP,           // ip = b
+    JUMP_IF_FALSE,  // pop; IF semantics: must be boolean, jump to b when false
+    JUMP_UNLESS_TRUE, // pop; WHILE semantics: jump to b unless it is TRUE!
+    FOR_PREP,       // pop step/end/start, bind slot a, jump to b when the range is empty; flags = FOR_*
+    FOR_LOOP,       // advance the counter bound to slot a, jump back to b while in range; flags = FOR_*
+    FOR_END,        // drop the loop state and unbind slot a
+    PARALLEL_FOR,   // pop step/end/start and run parallels[b]
+    LOAD_DLL,       // load names[a] as alias names[b]
+    CALL_DLL,       // run calls[b] with `flags` popped args, push its result
+    ASYNC_CALL,     // start calls[b] with `flags` popped args, push its handle
+    AWAIT,          // pop a handle, push the result of its call
+    DECLARE,        // register the signature of declarations[b]
+    POP,
+    CALL_EXPR,      // placeholder `OBJ::FN()` call on names[a], pushes NOTHING
+    SUMMON,         // run module names[a] with alias names[b]
+    PROFILE_ENTER,  // --profile only: statements[b] starts
+    PROFILE_EXIT,   // --profile only: the innermost statement is done
+    HALT
+};
+
+enum : uint8_t {
+    STORE_CONSTANT = 1 << 0,
+    STORE_LOCAL    = 1 << 1
+};
+
+enum : uint8_t {
+    FOR_COUNTED   = 1 << 0, // the variable is not stored; reads use LOAD_COUNTER
+    FOR_ASCENDING = 1 << 1  // the step is a positive literal
+};
+
+struct Instruction {
+    OpCode op;
+    uint8_t flags = 0;
+    uint32_t a = 0;
+    uint32_t b = 0;
+};
+
+struct JitCode;
+
+struct Chunk {
+    std::vector<Instruction> code;
+    std::vector<Value> constants;
+    std::vector<std::string> names;
+    std::vector<std::string> slotNames;
+    // CALLs and DECLAREs of the compiled Program. Calls keep their resolved
+    // function in the node, so the Program has to outlive the Chunk.
+    std::vector<CallDllExpr*> calls;
+    std::vector<const DeclareStatement*> declarations;
+    // PARALLEL FOR statements, whose bodies each worker compiles on its own.
+    std::vector<const ParallelForStatement*> parallels;
+    // Statements bracketed by PROFILE_ENTER/EXIT when compiled for --profile.
+    std::vector<const Statement*> statements;
+    // Loop counts and native code of --jit, created on the first back-edge.
+    mutable std::shared_ptr<JitCode> jit;
+};
@@ -0,0 +1,177 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define JORGESCRIPT_SCAN_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JORGESCRIPT_SCAN_SSE2 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// Locale-independent ASCII character classes for the Lexer. Each scan
+// returns the first position in [p, end) that is not in the class, 16 or 32
+// bytes at a time where SSE2/AVX2 are available and byte by byte otherwise.
+namespace charscan {
+
+enum : uint8_t {
+    SPACE = 1 << 0,
+    ALPHA = 1 << 1,
+    DIGIT = 1 << 2,
+    HEX   = 1 << 3,
+    LOWER = 1 << 4,
+    IDENT = 1 << 5,
+    NUMBER = 1 << 6,
+};
+
+constexpr std::array<uint8_t, 256> makeTable() {
+    std::array<uint8_t, 256> t{};
+    for (int c = 0; c < 256; c++) {
+        uint8_t f = 0;
+        if (c == ' ' || (c >= '\t' && c <= '\r')) f |= SPACE;
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) f |= ALPHA | IDENT;
+        if (c >= 'a' && c <= 'z') f |= LOWER;
+        if (c >= '0' && c <= '9') f |= DIGIT | HEX | IDENT | NUMBER;
+        if ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')) f |= HEX;
+        if (c == '.' || c == '_') f |= IDENT;
+        if (c == '.') f |= NUMBER;
+        t[c] = f;
+    }
+    return t;
+}
+
+inline constexpr std::array<uint8_t, 256> Table = makeTable();
+
+inline bool is(char c, uint8_t cls) {
+    return (Table[static_cast<unsigned char>(c)] & cls) != 0;
+}
+
+inline unsigned countTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+#if JORGESCRIPT_SCAN_AVX2
+using Vec = __m256i;
+constexpr size_t Width = 32;
+inline Vec load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+inline Vec splat(char c) { return _mm256_set1_epi8(c); }
+inline Vec eq(Vec a, Vec b) { return _mm256_cmpeq_epi8(a, b); }
+inline Vec orv(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+inline Vec andv(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+inline Vec ge(Vec v, char lo) { return eq(_mm256_max_epu8(v, splat(lo)), v); }
+inline Vec le(Vec v, char hi) { return eq(_mm256_min_epu8(v, splat(hi)), v); }
+inline uint32_t bits(Vec v) { return static_cast<uint32_t>(_mm256_movemask_epi8(v)); }
+constexpr uint32_t AllLanes = 0xFFFFFFFFu;
+#elif JORGESCRIPT_SCAN_SSE2
+using Vec = __m128i;
+constexpr size_t Width = 16;
+inline Vec load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+inline Vec splat(char c) { return _mm_set1_epi8(c); }
+inline Vec eq(Vec a, Vec b) { return _mm_cmpeq_epi8(a, b); }
+inline Vec orv(Vec a, Vec b) { return _mm_or_si128(a, b); }
+inline Vec andv(Vec a, Vec b) { return _mm_and_si128(a, b); }
+inline Vec ge(Vec v, char lo) { return eq(_mm_max_epu8(v, splat(lo)), v); }
+inline Vec le(Vec v, char hi) { return eq(_mm_min_epu8(v, splat(hi)), v); }
+inline uint32_t bits(Vec v) { return static_cast<uint32_t>(_mm_movemask_epi8(v)); }
+constexpr uint32_t AllLanes = 0xFFFFu;
+#endif
+
+#if JORGESCRIPT_SCAN_AVX2 || JORGESCRIPT_SCAN_SSE2
+inline Vec inRange(Vec v, char lo, char hi) { return andv(ge(v, lo), le(v, hi)); }
+
+// Most tokens are only a few bytes long, so the first bytes are checked
+// through the table; only runs that keep going switch to whole vectors.
+constexpr size_t ScalarPrefix = 8;
+
+template <typename Classify>
+inline const char* scanVector(const char* p, const char* end, uint8_t cls, Classify classify) {
+    for (size_t i = 0; i < ScalarPrefix; i++, p++)
+        if (p == end || !is(*p, cls)) return p;
+
+    while (static_cast<size_t>(end - p) >= Width) {
+        uint32_t match = bits(classify(load(p)));
+        if (match != AllLanes)
+            return p + countTrailingZeros(~match);
+        p += Width;
+    }
+    while (p < end && is(*p, cls)) p++;
+    return p;
+}
+#endif
+
+inline const char* skipSpace(const char* p, const char* end) {
+#if JORGESCRIPT_SCAN_AVX2 || JORGESCRIPT_SCAN_SSE2
+    return scanVector(p, end, SPACE, [](Vec v) {
+        return orv(eq(v, splat(' ')), inRange(v, '\t', '\r'));
+    });
+#else
+    while (p < end && is(*p, SPACE)) p++;
+    return p;
+#endif
+}
+
+// Also reports whether any lowercase letter was part of the word.
+inline const char* scanIdentifier(const char* p, const char* end, bool& lower) {
+#if JORGESCRIPT_SCAN_AVX2 || JORGESCRIPT_SCAN_SSE2
+    const char* start = p;
+    p = scanVector(p, end, IDENT, [](Vec v) {
+        return orv(orv(inRange(v, 'A', 'Z'), inRange(v, 'a', 'z')),
+                   orv(inRange(v, '0', '9'), orv(eq(v, splat('.')), eq(v, splat('_')))));
+    });
+    for (const char* q = start; q < p; q++)
+        if (is(*q, LOWER)) { lower = true; break; }
+    return p;
+#else
+    while (p < end && is(*p, IDENT)) {
+        if (is(*p, LOWER)) lower = true;
+        p++;
+    }
+    return p;
+#endif
+}
+
+inline const char* scanNumber(const char* p, const char* end) {
+#if JORGESCRIPT_SCAN_AVX2 || JORGESCRIPT_SCAN_SSE2
+    return scanVector(p, end, NUMBER, [](Vec v) {
+        return orv(inRange(v, '0', '9'), eq(v, splat('.')));
+    });
+#else
+    while (p < end && is(*p, NUMBER)) p++;
+    return p;
+#endif
+}
+
+inline const char* scanHex(const char* p, const char* end) {
+    while (p < end && is(*p, HEX)) p++;
+    return p;
+}
+
+inline const char* findQuote(const char* p, const char* end) {
+#if JORGESCRIPT_SCAN_AVX2 || JORGESCRIPT_SCAN_SSE2
+    for (size_t i = 0; i < ScalarPrefix; i++, p++)
+        if (p == end || *p == '"') return p;
+
+    while (static_cast<size_t>(end - p) >= Width) {
+        uint32_t quote = bits(eq(load(p), splat('"')));
+        if (quote)
+            return p + countTrailingZeros(quote);
+        p += Width;
+    }
+#endif
+    while (p < end && *p != '"') p++;
+    return p;
+}
+
+} // namespace charscan
@@ -0,0 +1,283 @@
+#include "Compiler.hpp"
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+Chunk Compiler::compile(const Program& program, const StatementList& body) {
+    chunk = Chunk();
+    nameIndex.clear();
+    numberIndex.clear();
+    stringIndex.clear();
+    trueIndex = falseIndex = nothingIndex = NoIndex;
+
+    chunk.slotNames = program.slotNames;
+    compileBlock(body);
+    emit(OpCode::HALT);
+
+    return std::move(chunk);
+}
+
+void Compiler::compileBlock(const StatementList& body) {
+    if (profile) {
+        for (Statement* stmt : body) {
+            chunk.statements.push_back(stmt);
+            emit(OpCode::PROFILE_ENTER, 0, static_cast<uint32_t>(chunk.statements.size() - 1));
+            stmt->compile(*this);
+            emit(OpCode::PROFILE_EXIT);
+        }
+        return;
+    }
+
+    for (Statement* stmt : body)
+        stmt->compile(*this);
+}
+
+size_t Compiler::emit(OpCode op, uint32_t a, uint32_t b, uint8_t flags) {
+    chunk.code.push_back({op, flags, a, b});
+    return chunk.code.size() - 1;
+}
+
+void Compiler::patchJump(size_t at) {
+    chunk.code[at].b = here();
+}
+
+uint32_t Compiler::here() const {
+    return static_cast<uint32_t>(chunk.code.size());
+}
+
+uint32_t Compiler::constant(const Value& value) {
+    // Equal literals share one entry. Numbers are told apart by their bits,
+    // so 0 and -0 stay distinct; strings are immutable ropes and can be
+    // shared.
+    uint32_t* known = nullptr;
+    switch (value.type) {
+        case ValueType::NUMBER: {
+            uint64_t bits;
+            std::memcpy(&bits, &value.number, sizeof(bits));
+            known = &numberIndex.try_emplace(bits, NoIndex).first->second;
+            break;
+        }
+        case ValueType::STRING:
+            known = &stringIndex.try_emplace(value.str(), NoIndex).first->second;
+            break;
+        case ValueType::BOOLEAN:
+            known = value.boolean ? &trueIndex : &falseIndex;
+            break;
+        case ValueType::NOTHING:
+            known = &nothingIndex;
+            break;
+        default:
+            break;
+    }
+    if (known && *known != NoIndex)
+        return *known;
+
+    if (chunk.constants.size() >= NoIndex)
+        throw std::runtime_error("Too many constants in one program");
+    chunk.constants.push_back(value);
+    uint32_t index = static_cast<uint32_t>(chunk.constants.size() - 1);
+    if (known) *known = index;
+    return index;
+}
+
+uint32_t Compiler::name(std::string_view name) {
+    auto it = nameIndex.find(name);
+    if (it != nameIndex.end())
+        return it->second;
+
+    if (chunk.names.size() >= NoIndex)
+        throw std::runtime_error("Too many names in one program");
+    uint32_t index = static_cast<uint32_t>(chunk.names.size());
+    chunk.names.emplace_back(name);
+    nameIndex.emplace(std::string(name), index);
+    return index;
+}
+
+void Compiler::load(uint32_t slot) {
+    for (size_t k = loops.size(); k-- > 0;) {
+        if (loops[k]->slot != slot) continue;
+        if (loops[k]->counted) {
+            emit(OpCode::LOAD_COUNTER, 0, static_cast<uint32_t>(3 * k));
+            return;
+        }
+        break;
+    }
+    emit(OpCode::LOAD, slot);
+}
+
+uint32_t Compiler::call(CallDllExpr* call) {
+    chunk.calls.push_back(call);
+    return static_cast<uint32_t>(chunk.calls.size() - 1);
+}
+
+uint32_t Compiler::declaration(const DeclareStatement* decl) {
+    chunk.declarations.push_back(decl);
+    return static_cast<uint32_t>(chunk.declarations.size() - 1);
+}
+
+uint32_t Compiler::parallel(const ParallelForStatement* loop) {
+    chunk.parallels.push_back(loop);
+    return static_cast<uint32_t>(chunk.parallels.size() - 1);
+}
+
+void LiteralExpr::compile(Compiler& c) {
+    c.emit(OpCode::CONSTANT, c.constant(value));
+}
+
+void VariableExpr::compile(Compiler& c) {
+    c.load(slot);
+}
+
+void BinaryExpr::compile(Compiler& c) {
+    left->compile(c);
+    right->compile(c);
+
+    if (op == '+')
+        c.emit(OpCode::ADD);
+    else if (op == '=')
+        c.emit(OpCode::EQUAL);
+    else
+        throw std::runtime_error("Unsupported binary op");
+}
+
+void ArrayExpr::compile(Compiler& c) {
+    if (size) {
+        size->compile(c);
+        c.emit(OpCode::ZEROS);
+        return;
+    }
+    for (Expr* expr : elements)
+        expr->compile(c);
+    c.emit(OpCode::ARRAY_OF, 0, static_cast<uint32_t>(elements.size()));
+}
+
+void IndexExpr::compile(Compiler& c) {
+    array->compile(c);
+    index->compile(c);
+    c.emit(OpCode::INDEX);
+}
+
+void LengthExpr::compile(Compiler& c) {
+    value->compile(c);
+    c.emit(OpCode::LENGTH);
+}
+
+void CallExpr::compile(Compiler& c) {
+    c.emit(OpCode::CALL_EXPR, c.name(function));
+}
+
+void SetStatement::compile(Compiler& c) {
+    expr->compile(c);
+
+    uint8_t flags = 0;
+    if (isconstant) flags |= STORE_CONSTANT;
+    if (isLocal) flags |= STORE_LOCAL;
+    c.emit(OpCode::STORE, slot, 0, flags);
+}
+
+void SetElementStatement::compile(Compiler& c) {
+    index->compile(c);
+    expr->compile(c);
+    c.emit(OpCode::STORE_ELEMENT, slot);
+}
+
+void PrintStatement::compile(Compiler& c) {
+    expr->compile(c);
+    c.emit(OpCode::PRINT);
+}
+
+void IfStatement::compile(Compiler& c) {
+    condition->compile(c);
+    size_t skip = c.emit(OpCode::JUMP_IF_FALSE);
+    c.compileBlock(body);
+    c.patchJump(skip);
+}
+
+void LoadDllStatement::compile(Compiler& c) {
+    c.emit(OpCode::LOAD_DLL, c.name(dllName), c.name(alias));
+}
+
+void CallDllExpr::compile(Compiler& c) {
+    if (args.size() > std::numeric_limits<uint8_t>::max())
+        throw std::runtime_error("Too many arguments for CALL");
+
+    for (Expr* arg : args)
+        arg->compile(c);
+    c.emit(OpCode::CALL_DLL, 0, c.call(this), static_cast<uint8_t>(args.size()));
+}
+
+void CallDllStatement::compile(Compiler& c) {
+    call->compile(c);
+    c.emit(OpCode::POP);
+}
+
+void AsyncCallStatement::compile(Compiler& c) {
+    if (call->args.size() > std::numeric_limits<uint8_t>::max())
+        throw std::runtime_error("Too many arguments for CALL");
+
+    for (Expr* arg : call->args)
+        arg->compile(c);
+    c.emit(OpCode::ASYNC_CALL, 0, c.call(call), static_cast<uint8_t>(call->args.size()));
+    c.emit(OpCode::STORE, slot, 0, STORE_LOCAL);
+}
+
+void AwaitExpr::compile(Compiler& c) {
+    handle->compile(c);
+    c.emit(OpCode::AWAIT);
+}
+
+void AwaitStatement::compile(Compiler& c) {
+    await->compile(c);
+    c.emit(OpCode::POP);
+}
+
+void DeclareStatement::compile(Compiler& c) {
+    c.emit(OpCode::DECLARE, 0, c.declaration(this));
+}
+
+void SummonStatement::compile(Compiler& c) {
+    c.emit(OpCode::SUMMON, c.name(filename), c.name(alias));
+}
+
+void WhileStatement::compile(Compiler& c) {
+    uint32_t top = c.here();
+    condition->compile(c);
+    size_t exit = c.emit(OpCode::JUMP_UNLESS_TRUE);
+    c.compileBlock(body);
+    c.emit(OpCode::JUMP, 0, top);
+    c.patchJump(exit);
+}
+
+void ForStatement::compile(Compiler& c) {
+
+    startExpr->compile(c);
+    endExpr->compile(c);
+    if (stepExpr)
+        stepExpr->compile(c);
+    else
+        c.emit(OpCode::CONSTANT, c.constant(Value(1.0)));
+
+    uint8_t flags = counted ? FOR_COUNTED : 0;
+    LiteralExpr* step = stepExpr ? stepExpr->asLiteral() : nullptr;
+    if (!stepExpr || (step && step->value.type == ValueType::NUMBER && step->value.number > 0))
+        flags |= FOR_ASCENDING;
+
+    size_t prep = c.emit(OpCode::FOR_PREP, slot, 0, flags);
+    uint32_t top = c.here();
+    c.enterLoop(this);
+    c.compileBlock(body);
+    c.exitLoop();
+    c.emit(OpCode::FOR_LOOP, slot, top, flags);
+    c.patchJump(prep);
+    c.emit(OpCode::FOR_END, slot);
+}
+
+void ParallelForStatement::compile(Compiler& c) {
+    startExpr->compile(c);
+    endExpr->compile(c);
+    if (stepExpr)
+        stepExpr->compile(c);
+    else
+        c.emit(OpCode::CONSTANT, c.constant(Value(1.0)));
+    c.emit(OpCode::PARALLEL_FOR, 0, c.parallel(this));
+}
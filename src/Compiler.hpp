@@ -0,0 +1,49 @@
+#pragma once
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "AST.hpp"
+#include "Bytecode.hpp"
+
+class Compiler {
+public:
+    // With `profile`, every statement is bracketed by PROFILE_ENTER/EXIT.
+    explicit Compiler(bool profile = false) : profile(profile) {}
+
+    Chunk compile(const Program& program) { return compile(program, program.statements); }
+    // Only `body`, a run of the program's top-level statements.
+    Chunk compile(const Program& program, const StatementList& body);
+
+    void compileBlock(const StatementList& body);
+
+    size_t emit(OpCode op, uint32_t a = 0, uint32_t b = 0, uint8_t flags = 0);
+    void patchJump(size_t at);
+    uint32_t here() const;
+
+    uint32_t constant(const Value& value);
+    uint32_t name(std::string_view name);
+    void load(uint32_t slot);
+    void enterLoop(const ForStatement* loop) { loops.push_back(loop); }
+    void exitLoop() { loops.pop_back(); }
+    uint32_t call(CallDllExpr* call);
+    uint32_t declaration(const DeclareStatement* decl);
+    uint32_t parallel(const ParallelForStatement* loop);
+
+private:
+    bool profile;
+    Chunk chunk;
+    static constexpr uint32_t NoIndex = std::numeric_limits<uint32_t>::max();
+
+    NameMap<uint32_t> nameIndex;
+    // Constant-table entries by literal, so equal literals share one.
+    std::unordered_map<uint64_t, uint32_t> numberIndex;
+    NameMap<uint32_t> stringIndex;
+    uint32_t trueIndex = NoIndex;
+    uint32_t falseIndex = NoIndex;
+    uint32_t nothingIndex = NoIndex;
+    // FOR statements enclosing the code being compiled. Statements leave the
+    // VM stack balanced, so the state of loop k sits at stack[3 * k].
+    std::vector<const ForStatement*> loops;
+};
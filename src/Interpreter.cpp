@@ -0,0 +1,364 @@
+#include "Interpreter.hpp"
+#include "Compiler.hpp"
+#include "Runtime.hpp"
+#include "ThreadPool.hpp"
+#include "VM.hpp"
+#include <limits>
+#include <stdexcept>
+
+Interpreter::Interpreter() : Interpreter(Options()) {}
+
+Interpreter::Interpreter(const Options& options) : options(options) {
+    output.stream = options.out;
+    output.policy = options.flush;
+    profiler.enabled = options.profile;
+}
+
+Interpreter::~Interpreter() {
+    finishCalls();
+    output.sync();
+}
+
+Program Interpreter::load(const std::string& path, size_t threads) {
+    Program program = parseFile(path);
+    modules.prefetch(program, threads);
+    return program;
+}
+
+Program Interpreter::loadSource(std::string_view source, size_t threads) {
+    Program program = parseSource(source);
+    modules.prefetch(program, threads);
+    return program;
+}
+
+void Interpreter::run(const Program& program) {
+    finishCalls();
+    scopes.clear();
+    pushScope(program.slotNames);
+    runPart(program, 0, program.statements.size());
+    finishCalls();
+}
+
+void Interpreter::runPart(const Program& program, size_t first, size_t last) {
+    if (output.stream != options.out) output.sync();
+    output.stream = options.out;
+    output.policy = options.flush;
+    profiler.enabled = options.profile;
+
+    StatementList part{program.statements.items + first, static_cast<uint32_t>(last - first)};
+    if (options.treeWalk) {
+        execute(part);
+    } else {
+        Chunk chunk = Compiler(options.profile).compile(program, part);
+        VM(*this).run(chunk);
+    }
+}
+
+void Interpreter::reset() {
+    finishCalls();
+    scopes.clear();
+    workers.clear();
+    fileScopes.clear();
+    libraries.clear();
+    signatures.clear();
+    libraryGeneration++;
+    modules.refresh();
+    profiler.reset();
+    jitStats = {};
+    quickening = {};
+}
+
+void Interpreter::print(const Value& val) {
+    switch(val.type){
+        case ValueType::STRING:  output.write(val.str()); break;
+        case ValueType::NUMBER: {
+            char text[NumberBufferSize];
+            output.write({text, formatNumber(text, val.number)});
+            break;
+        }
+        case ValueType::BOOLEAN: output.write(val.boolean?"TRUE!":"Untrue..."); break;
+        case ValueType::NOTHING: output.write("NOTHING"); break;
+        case ValueType::ARRAY:   output.write(arrayText(*val.array)); break;
+        default:                 output.write("IDK"); break;
+    }
+    output.endLine();
+}
+
+void Interpreter::assignVariable(uint32_t slot, std::string_view name, const Value& val, bool isconstant, bool isLocal) {
+    Variable& own = scopes.back().slots[slot];
+
+    if (isLocal) {
+        own = {val, isconstant, true};
+        return;
+    }
+
+    Variable* found = own.defined ? &own : findVariable(name);
+    if (found) {
+        if (found->isconstant && parallelWorker)
+            throw std::runtime_error("Cannot SET " + std::string(name) +
+                                     " inside PARALLEL FOR (use INSIDE SET or REDUCE)");
+        if (found->isconstant)
+            throw std::runtime_error("Cannot modify constant: " + std::string(name));
+        found->value = val;
+        return;
+    }
+
+    if (parallelWorker)
+        throw std::runtime_error("Cannot SET " + std::string(name) + " inside PARALLEL FOR (use INSIDE SET or REDUCE)");
+    scopes.front().define(name) = {val, isconstant, true};
+}
+
+void Interpreter::storeElement(uint32_t slot, std::string_view name, const Value& index, const Value& val) {
+    Variable& own = scopes.back().slots[slot];
+    Variable* var = own.defined ? &own : findVariable(name);
+    if (!var)
+        throw std::runtime_error("Undefined variable: " + std::string(name));
+    if (var->value.type != ValueType::ARRAY)
+        throw std::runtime_error("Only arrays can be indexed: " + std::string(name));
+    if (var->isconstant && parallelWorker)
+        throw std::runtime_error("Cannot SET " + std::string(name) + " inside PARALLEL FOR (use INSIDE SET or REDUCE)");
+    if (var->isconstant)
+        throw std::runtime_error("Cannot modify constant: " + std::string(name));
+    if (val.type != ValueType::NUMBER)
+        throw std::runtime_error("Array elements must be numbers");
+
+    size_t offset = elementOffset(*var->value.array, index);
+    if (var->value.array->shared())
+        var->value = Value(var->value.array->clone());
+    var->value.array->data()[offset] = val.number;
+}
+
+void Interpreter::loadLibrary(std::string_view dllName, std::string_view alias) {
+    std::string path(dllName);
+    LibraryHandle& library = openedLibraries[path];
+    if (!library)
+        library = openLibrary(path);
+    if (!library) {
+        openedLibraries.erase(path);
+        throw std::runtime_error("Failed to load DLL: " + path);
+    }
+
+    libraries[std::string(alias)] = library;
+    libraryGeneration++;
+}
+
+void Interpreter::declareFunction(const DeclareStatement& decl) {
+    if (decl.argTypes.size() > MaxFfiArgs)
+        throw std::runtime_error("Too many arguments in DECLARE (at most " + std::to_string(MaxFfiArgs) + ")");
+
+    std::string key(decl.alias);
+    key += "::";
+    key += decl.function;
+
+    FfiSignature& sig = signatures[key];
+    sig.ret = decl.returnType;
+    sig.arity = static_cast<uint8_t>(decl.argTypes.size());
+    for (size_t i = 0; i < decl.argTypes.size(); i++)
+        sig.args[i] = decl.argTypes[i];
+    sig.trampoline = findTrampoline(sig.ret, sig.args.data(), sig.arity);
+    libraryGeneration++;
+}
+
+namespace {
+void resolveCall(Interpreter& in, CallDllExpr& call) {
+    CallSite& site = call.site;
+
+    auto it = in.libraries.find(call.alias);
+    if (it == in.libraries.end())
+        throw std::runtime_error("DLL not loaded: " + std::string(call.alias));
+
+    std::string symbol(call.function);
+    void* proc = findSymbol(it->second, symbol);
+    if (!proc)
+        throw std::runtime_error("Function not found: " + symbol);
+
+    std::string key(call.alias);
+    key += "::";
+    key += symbol;
+    auto sig = in.signatures.find(key);
+
+    site.fn = proc;
+    site.signature = sig == in.signatures.end() ? nullptr : &sig->second;
+    site.generation = in.libraryGeneration;
+}
+
+[[noreturn]] void argumentMismatch(const CallDllExpr& call, size_t i) {
+    throw std::runtime_error("Wrong type for argument " + std::to_string(i + 1) + " of " + std::string(call.function));
+}
+
+FfiSlot toSlot(const CallDllExpr& call, size_t i, const Value& v, FfiType type) {
+    FfiSlot slot;
+    slot.i = 0;
+    switch (type) {
+        case FfiType::BOOL:
+        case FfiType::INT:
+        case FfiType::INT64:
+            if (v.type == ValueType::NUMBER) slot.i = static_cast<int64_t>(v.number);
+            else if (v.type == ValueType::BOOLEAN) slot.i = v.boolean ? 1 : 0;
+            else argumentMismatch(call, i);
+            break;
+        case FfiType::DOUBLE:
+            if (v.type != ValueType::NUMBER) argumentMismatch(call, i);
+            slot.d = v.number;
+            break;
+        case FfiType::PTR:
+            if (v.type == ValueType::NUMBER) slot.i = static_cast<int64_t>(v.number);
+            else if (v.type == ValueType::STRING) slot.i = reinterpret_cast<intptr_t>(v.str().c_str());
+            else if (v.type == ValueType::ARRAY) slot.i = reinterpret_cast<intptr_t>(v.array->data());
+            else if (v.type != ValueType::NOTHING) argumentMismatch(call, i);
+            break;
+        case FfiType::STRING:
+            if (v.type == ValueType::STRING) slot.i = reinterpret_cast<intptr_t>(v.str().c_str());
+            else if (v.type != ValueType::NOTHING) argumentMismatch(call, i);
+            break;
+        default:
+            argumentMismatch(call, i);
+    }
+    return slot;
+}
+
+Value fromSlot(FfiSlot slot, FfiType type) {
+    switch (type) {
+        case FfiType::BOOL:   return Value(slot.i != 0);
+        case FfiType::INT:
+        case FfiType::INT64:  return Value(static_cast<double>(slot.i));
+        case FfiType::DOUBLE: return Value(slot.d);
+        case FfiType::PTR:
+            if (!slot.i) return Value();
+            return Value(static_cast<double>(slot.i));
+        case FfiType::STRING:
+            if (!slot.i) return Value();
+            return Value(std::string(reinterpret_cast<const char*>(static_cast<intptr_t>(slot.i))));
+        default:              return Value();
+    }
+}
+
+Value callStub(CallDllExpr& call, const Value* args, size_t argc) {
+    if (argc > std::numeric_limits<uint8_t>::max())
+        throw std::runtime_error("Too many arguments for CALL");
+
+    void* argv[std::numeric_limits<uint8_t>::max()];
+#ifdef _WIN32
+    std::vector<std::wstring> wstrings;
+#endif
+
+    for (size_t i = 0; i < argc; i++) {
+        const Value& v = args[i];
+        if (v.type == ValueType::NUMBER) {
+            argv[i] = reinterpret_cast<void*>(static_cast<intptr_t>(v.number));
+        } else if (v.type == ValueType::BOOLEAN) {
+            argv[i] = reinterpret_cast<void*>(static_cast<intptr_t>(v.boolean ? 1 : 0));
+        } else if (v.type == ValueType::STRING) {
+#ifdef _WIN32
+            if (wstrings.empty()) wstrings.reserve(argc);
+            wstrings.push_back(utf8ToUtf16(v.str()));
+            argv[i] = (void*)wstrings.back().c_str();
+#else
+            argv[i] = (void*)v.str().c_str();
+#endif
+        } else if (v.type == ValueType::ARRAY) {
+            argv[i] = v.array->data();
+        } else {
+            throw std::runtime_error("Unsupported argument type");
+        }
+    }
+
+    LibraryFunction fn = reinterpret_cast<LibraryFunction>(call.site.fn);
+    return Value(static_cast<double>(fn(static_cast<int>(argc), argv)));
+}
+
+} // namespace
+
+Value Interpreter::callLibrary(CallDllExpr& call, const Value* args, size_t argc) {
+    CallSite& site = call.site;
+    if (!site.fn || site.generation != libraryGeneration)
+        resolveCall(*this, call);
+
+    // Foreign code prints through stdio, so lines PRINTed so far go first.
+    output.flush();
+
+    const FfiSignature* sig = site.signature;
+    if (!sig)
+        return callStub(call, args, argc);
+
+    if (argc != sig->arity)
+        throw std::runtime_error("Wrong number of arguments for " + std::string(call.function));
+
+    for (size_t i = 0; i < argc; i++)
+        site.args[i] = toSlot(call, i, args[i], sig->args[i]);
+
+    FfiSlot ret;
+    ret.i = 0;
+    sig->trampoline(site.fn, site.args, &ret);
+    return fromSlot(ret, sig->ret);
+}
+
+ForeignCall Interpreter::prepareCall(CallDllExpr& call, const Value* args, size_t argc) {
+    CallSite& site = call.site;
+    if (!site.fn || site.generation != libraryGeneration)
+        resolveCall(*this, call);
+    output.flush();
+
+    ForeignCall prepared;
+    prepared.fn = site.fn;
+    prepared.strings.reserve(argc);
+
+    if (const FfiSignature* sig = site.signature) {
+        if (argc != sig->arity)
+            throw std::runtime_error("Wrong number of arguments for " + std::string(call.function));
+        prepared.typed = true;
+        prepared.signature = *sig;
+        for (size_t i = 0; i < argc; i++) {
+            prepared.args[i] = toSlot(call, i, args[i], sig->args[i]);
+            if (args[i].type == ValueType::STRING)
+                prepared.args[i].i = reinterpret_cast<intptr_t>(prepared.strings.emplace_back(args[i].str()).c_str());
+            else if (args[i].type == ValueType::ARRAY)
+                prepared.arrays.push_back(args[i]);
+        }
+        return prepared;
+    }
+
+    if (argc > std::numeric_limits<uint8_t>::max())
+        throw std::runtime_error("Too many arguments for CALL");
+#ifdef _WIN32
+    prepared.wide.reserve(argc);
+#endif
+    for (size_t i = 0; i < argc; i++) {
+        const Value& v = args[i];
+        if (v.type == ValueType::NUMBER) {
+            prepared.argv.push_back(reinterpret_cast<void*>(static_cast<intptr_t>(v.number)));
+        } else if (v.type == ValueType::BOOLEAN) {
+            prepared.argv.push_back(reinterpret_cast<void*>(static_cast<intptr_t>(v.boolean ? 1 : 0)));
+        } else if (v.type == ValueType::STRING) {
+#ifdef _WIN32
+            prepared.argv.push_back((void*)prepared.wide.emplace_back(utf8ToUtf16(v.str())).c_str());
+#else
+            prepared.argv.push_back((void*)prepared.strings.emplace_back(v.str()).c_str());
+#endif
+        } else if (v.type == ValueType::ARRAY) {
+            prepared.arrays.push_back(v);
+            prepared.argv.push_back(v.array->data());
+        } else {
+            throw std::runtime_error("Unsupported argument type");
+        }
+    }
+    return prepared;
+}
+
+void ForeignCall::invoke() {
+    if (!typed) {
+        ret.i = reinterpret_cast<LibraryFunction>(fn)(static_cast<int>(argv.size()), argv.data());
+        return;
+    }
+    signature.trampoline(fn, args, &ret);
+    if (signature.ret == FfiType::STRING && ret.i)
+        text = reinterpret_cast<const char*>(static_cast<intptr_t>(ret.i));
+}
+
+Value ForeignCall::result() const {
+    if (!typed)
+        return Value(static_cast<double>(ret.i));
+    if (signature.ret == FfiType::STRING)
+        return ret.i ? Value(text) : Value();
+    return fromSlot(ret, signature.ret);
+}
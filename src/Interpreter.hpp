@@ -0,0 +1,197 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "AST.hpp"
+#include "Async.hpp"
+#include "Jit.hpp"
+#include "Library.hpp"
+#include "ModuleRegistry.hpp"
+#include "Output.hpp"
+#include "Profiler.hpp"
+
+class StealingPool;
+
+// A frame of variables. Slots laid out by the Resolver are addressed
+// directly; `names` maps every slot back to its name for the dynamic
+// lookups a SUMMONed module does into the frames of its callers.
+struct Scope {
+    std::vector<Variable> slots;
+    NameMap<uint32_t> names;
+
+    Scope() = default;
+    explicit Scope(const std::vector<std::string>& layout) : slots(layout.size()) {
+        names.reserve(layout.size());
+        for (uint32_t i = 0; i < layout.size(); i++)
+            names.emplace(layout[i], i);
+    }
+
+    Variable* find(std::string_view name) {
+        auto it = names.find(name);
+        if (it == names.end() || !slots[it->second].defined) return nullptr;
+        return &slots[it->second];
+    }
+
+    Variable& define(std::string_view name) {
+        auto it = names.find(name);
+        if (it != names.end()) return slots[it->second];
+        names.emplace(std::string(name), static_cast<uint32_t>(slots.size()));
+        return slots.emplace_back();
+    }
+};
+
+// Everything a running script touches: its frames, the libraries it loaded
+// by alias, its DECLAREd signatures, the modules it SUMMONed, its output
+// and its profiler. Interpreters share none of it, so separate threads can
+// each run their own. One Interpreter runs one script at a time, and the
+// Programs it loads (whose call sites and quickened nodes it updates) are
+// only run by it.
+//
+//     Interpreter in;
+//     Program program = in.load("job.jorge");
+//     in.run(program);
+//
+// Errors in the script are thrown as std::runtime_error.
+class Interpreter {
+public:
+    // Taken up again by every run(), so they may change between runs.
+    struct Options {
+        // Walk the AST instead of compiling to bytecode.
+        bool treeWalk = false;
+        // Compile hot loops to native code where Jit::available().
+        bool jit = false;
+        bool profile = false;
+        std::FILE* out = stdout;
+        FlushPolicy flush = FlushPolicy::SIZE;
+        // Threads of a PARALLEL FOR, the calling one included; 0 is one per
+        // core. Its output and results do not depend on this.
+        size_t threads = 0;
+    };
+
+    Interpreter();
+    explicit Interpreter(const Options& options);
+    ~Interpreter();
+
+    Interpreter(const Interpreter&) = delete;
+    Interpreter& operator=(const Interpreter&) = delete;
+
+    // Parses a script and, on `threads` threads, every module it can
+    // SUMMON. Parsing only uses process-wide settings (Optimizer, ScriptCache),
+    // so any thread may load while others run.
+    Program load(const std::string& path, size_t threads = 1);
+    Program loadSource(std::string_view source, size_t threads = 1);
+
+    // Runs `program` in a fresh global frame. PRINT output still buffered
+    // when it returns or throws is written by sync() or the destructor.
+    void run(const Program& program);
+    // Runs the top-level statements [first, last) of `program` on the frames
+    // as they are. A --watch session runs its script this way, in parts it
+    // can resume from (see Watch.cpp).
+    void runPart(const Program& program, size_t first, size_t last);
+    void sync() { output.sync(); }
+
+    // Forgets the globals, aliases, signatures, profile and counters of
+    // earlier runs. Modules stay parsed unless their file changed, and
+    // opened libraries stay open.
+    void reset();
+
+    // The rest is the interface of the tree walker, the VM and the JIT.
+
+    void execute(const StatementList& body) {
+        if (profiler.enabled) [[unlikely]] {
+            profiler.execute(*this, body);
+            return;
+        }
+        for (Statement* stmt : body)
+            stmt->execute(*this);
+    }
+
+    void pushScope(const std::vector<std::string>& layout) { scopes.emplace_back(layout); }
+    void popScope() { scopes.pop_back(); }
+
+    Variable* findVariable(std::string_view name) {
+        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+            if (Variable* v = it->find(name)) return v;
+        }
+        return nullptr;
+    }
+
+    const Value& loadVariable(uint32_t slot, std::string_view name) {
+        Variable& own = scopes.back().slots[slot];
+        if (own.defined) return own.value;
+
+        Variable* v = findVariable(name);
+        if (!v) throw std::runtime_error("Undefined variable: " + std::string(name));
+        return v->value;
+    }
+
+    void assignVariable(uint32_t slot, std::string_view name, const Value& val, bool isconstant, bool isLocal);
+    // SET A[I] TO val, copying the array first if another value shares it.
+    void storeElement(uint32_t slot, std::string_view name, const Value& index, const Value& val);
+
+    void setLoopVariable(uint32_t slot, double i) {
+        Variable& var = scopes.back().slots[slot];
+        if (var.value.type == ValueType::NUMBER) {
+            var.value.number = i;
+            var.isconstant = false;
+            var.defined = true;
+            return;
+        }
+        var = {Value(i), false, true};
+    }
+
+    void eraseLoopVariable(uint32_t slot) { scopes.back().slots[slot] = {}; }
+
+    // Runs a PARALLEL FOR over [start, end] by `step` (see Parallel.cpp).
+    void runParallel(const ParallelForStatement& loop, const Value& start, const Value& end, const Value& step);
+
+    void print(const Value& val);
+    void loadLibrary(std::string_view dllName, std::string_view alias);
+    void declareFunction(const DeclareStatement& decl);
+    Value callLibrary(CallDllExpr& call, const Value* args, size_t argc);
+    ForeignCall prepareCall(CallDllExpr& call, const Value* args, size_t argc);
+
+    // ASYNC CALL starts the foreign function on callPool and returns a
+    // handle; AWAIT runs the event loop until that call is back. Calls
+    // nobody awaited are waited for by finishCalls(), at the end of every
+    // run and PARALLEL FOR piece (see Async.cpp).
+    double startCall(CallDllExpr& call, const Value* args, size_t argc);
+    Value awaitCall(const Value& handle);
+    void finishCalls();
+
+    Options options;
+    std::vector<Scope> scopes;
+    NameMap<Scope> fileScopes;
+    // Libraries by the alias LOADDLL gave them.
+    NameMap<LibraryHandle> libraries;
+    // Every library opened so far, by path. Handles are never closed, so a
+    // long-lived Interpreter opens each library once.
+    NameMap<LibraryHandle> openedLibraries;
+    // Signatures given by DECLARE, keyed by "ALIAS::function".
+    NameMap<FfiSignature> signatures;
+    // Bumped by every LOADDLL and DECLARE so cached call sites know to
+    // resolve again.
+    uint64_t libraryGeneration = 0;
+    ModuleRegistry modules;
+    Output output;
+    Profiler profiler;
+    JitStats jitStats;
+    Quickening quickening;
+
+    // Set in the interpreters that run the pieces of a PARALLEL FOR: the
+    // frames they were handed are copies, so SET may not create globals.
+    bool parallelWorker = false;
+    EventLoop events;
+    std::unique_ptr<ThreadPool> callPool;
+    std::unordered_map<uint64_t, AsyncCall> asyncCalls;
+    uint64_t lastHandle = 0;
+    std::unique_ptr<StealingPool> pool;
+    // One per pool thread, created on first use.
+    std::vector<std::unique_ptr<Interpreter>> workers;
+};
@@ -0,0 +1,370 @@
+#include "Jit.hpp"
+#include "Interpreter.hpp"
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define JORGESCRIPT_JIT 1
+#include <sys/mman.h>
+#endif
+
+namespace {
+using NativeLoop = uint32_t (*)(Variable* slots, Value* stack);
+
+// A slot the compiled code reads or writes, with the type it was compiled
+// for. Stored slots must also not be constant.
+struct Guard {
+    uint32_t slot;
+    ValueType type;
+    bool stored;
+};
+
+struct Loop {
+    enum State : uint8_t { COUNTING, COMPILED, REJECTED };
+
+    State state = COUNTING;
+    uint32_t count = 0;
+    NativeLoop code = nullptr;
+    size_t codeSize = 0;
+    // VM stack size at the back-edge; loop states sit below it.
+    size_t depth = 0;
+    std::vector<Guard> guards;
+};
+
+} // namespace
+
+struct JitCode {
+    std::unordered_map<uint32_t, Loop> loops;
+
+    JitCode() = default;
+    JitCode(const JitCode&) = delete;
+    JitCode& operator=(const JitCode&) = delete;
+
+    ~JitCode() {
+#ifdef JORGESCRIPT_JIT
+        for (auto& [backEdge, loop] : loops)
+            if (loop.code) munmap(reinterpret_cast<void*>(loop.code), loop.codeSize);
+#endif
+    }
+};
+
+#ifdef JORGESCRIPT_JIT
+namespace {
+static_assert(std::is_standard_layout_v<Value>, "the JIT addresses Value fields by offset");
+static_assert(std::is_standard_layout_v<Variable>, "the JIT addresses Variable fields by offset");
+
+// Native code receives the frame's slots in rdi and the VM stack in rsi.
+// Operand stack entry i lives in xmm i; booleans are held as 0.0 or 1.0.
+enum : int { RAX = 0, RSI = 6, RDI = 7 };
+constexpr int Limit = 13;
+constexpr int Counter = 14;
+constexpr int Zero = 15;
+constexpr size_t MaxDepth = 13;
+
+enum : uint8_t { CC_B = 0x2, CC_E = 0x4 };
+
+// Slots past this have no 32-bit displacement; loops using them stay in
+// the VM.
+constexpr uint32_t MaxSlot = (INT32_MAX - sizeof(Variable)) / sizeof(Variable);
+
+int32_t slotOffset(uint32_t slot) {
+    return static_cast<int32_t>(slot * sizeof(Variable) + offsetof(Variable, value) + offsetof(Value, number));
+}
+
+int32_t stackOffset(size_t index) {
+    return static_cast<int32_t>(index * sizeof(Value) + offsetof(Value, number));
+}
+
+// Just the handful of SSE2 and integer instructions the templates need.
+class Assembler {
+public:
+    std::vector<uint8_t> code;
+
+    size_t here() const { return code.size(); }
+
+    void loadNumber(int xmm, int base, int32_t disp) { sseMem(0xF2, 0x10, xmm, base, disp); }
+    void storeNumber(int base, int32_t disp, int xmm) { sseMem(0xF2, 0x11, xmm, base, disp); }
+    void add(int dst, int src) { sse(0xF2, 0x58, dst, src); }
+    void compare(int a, int b) { sse(0x66, 0x2E, a, b); }
+    void clear(int xmm) { sse(0x66, 0x57, xmm, xmm); }
+
+    void constant(int xmm, double v) {
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        if (bits == 0) {
+            clear(xmm);
+            return;
+        }
+        byte(0x48); byte(0xB8); u64(bits);  // mov rax, imm64
+        byte(0x66); rex(true, xmm, RAX); byte(0x0F); byte(0x6E); modrm(3, xmm, RAX);  // movq xmm, rax
+    }
+
+    void loadBool(int xmm, int base, int32_t disp) {
+        byte(0x0F); byte(0xB6); modrm(2, RAX, base); u32(disp);  // movzx eax, byte [base + disp]
+        sse(0xF2, 0x2A, xmm, RAX);  // cvtsi2sd xmm, eax
+    }
+
+    void storeBool(int base, int32_t disp, int xmm) {
+        sse(0xF2, 0x2C, RAX, xmm);  // cvttsd2si eax, xmm
+        byte(0x88); modrm(2, RAX, base); u32(disp);  // mov [base + disp], al
+    }
+
+    // xmm = 1.0 when the last compare found its operands equal (and ordered).
+    void setEqual(int xmm) {
+        byte(0x0F); byte(0x94); byte(0xC0);  // sete al
+        byte(0x0F); byte(0x9B); byte(0xC1);  // setnp cl
+        byte(0x20); byte(0xC8);              // and al, cl
+        byte(0x0F); byte(0xB6); byte(0xC0);  // movzx eax, al
+        sse(0xF2, 0x2A, xmm, RAX);
+    }
+
+    size_t jump() { byte(0xE9); return rel32(); }
+    size_t jumpIf(uint8_t cc) { byte(0x0F); byte(0x80 | cc); return rel32(); }
+
+    void patch(size_t at, size_t target) {
+        int32_t rel = static_cast<int32_t>(target) - static_cast<int32_t>(at + 4);
+        std::memcpy(code.data() + at, &rel, sizeof(rel));
+    }
+
+    void exit(uint32_t ip) {
+        byte(0xB8); u32(ip);  // mov eax, ip
+        byte(0xC3);           // ret
+    }
+
+private:
+    void byte(uint8_t b) { code.push_back(b); }
+    void u32(uint32_t v) { for (int i = 0; i < 4; i++) byte(static_cast<uint8_t>(v >> (8 * i))); }
+    void u64(uint64_t v) { for (int i = 0; i < 8; i++) byte(static_cast<uint8_t>(v >> (8 * i))); }
+    size_t rel32() { size_t at = here(); u32(0); return at; }
+
+    void rex(bool wide, int reg, int rm) {
+        uint8_t r = 0x40 | (wide ? 8 : 0) | (reg >= 8 ? 4 : 0) | (rm >= 8 ? 1 : 0);
+        if (r != 0x40) byte(r);
+    }
+    void modrm(int mod, int reg, int rm) { byte(static_cast<uint8_t>(mod << 6 | (reg & 7) << 3 | (rm & 7))); }
+
+    void sse(uint8_t prefix, uint8_t op, int reg, int rm) {
+        byte(prefix); rex(false, reg, rm); byte(0x0F); byte(op); modrm(3, reg, rm);
+    }
+    void sseMem(uint8_t prefix, uint8_t op, int reg, int base, int32_t disp) {
+        byte(prefix); rex(false, reg, base); byte(0x0F); byte(op); modrm(2, reg, base); u32(static_cast<uint32_t>(disp));
+    }
+};
+
+// Translates the loop [top, backEdge] instruction by instruction. Anything
+// outside the supported subset, or a type the interpreter would reject,
+// leaves the loop to the interpreter for good.
+bool compileLoop(const Chunk& chunk, uint32_t top, uint32_t backEdge, const Scope& frame, Loop& loop) {
+    Assembler a;
+    std::vector<ValueType> stack;
+    std::vector<int64_t> depthAt(backEdge - top + 1, -1);
+    std::vector<size_t> offsets(backEdge - top + 1, 0);
+    struct Fixup { size_t at; uint32_t target; };
+    std::vector<Fixup> fixups;
+    std::vector<Fixup> exits;
+
+    auto slotType = [&](uint32_t slot, bool stored) -> ValueType {
+        const Variable* var = slot < frame.slots.size() && slot <= MaxSlot ? &frame.slots[slot] : nullptr;
+        if (!var || !var->defined) return ValueType::IDK;
+        if (stored && var->isconstant) return ValueType::IDK;
+        for (Guard& g : loop.guards) {
+            if (g.slot == slot) {
+                g.stored |= stored;
+                return g.type;
+            }
+        }
+        ValueType type = var->value.type;
+        if (type != ValueType::NUMBER && type != ValueType::BOOLEAN) return ValueType::IDK;
+        loop.guards.push_back({slot, type, stored});
+        return type;
+    };
+
+    auto branch = [&](size_t at, uint32_t target) {
+        if (target > top && target <= backEdge) {
+            depthAt[target - top] = static_cast<int64_t>(stack.size());
+            fixups.push_back({at, target});
+        } else {
+            exits.push_back({at, target});
+        }
+    };
+
+    for (uint32_t ip = top; ip <= backEdge; ip++) {
+        const Instruction& ins = chunk.code[ip];
+        if (depthAt[ip - top] >= 0 && depthAt[ip - top] != static_cast<int64_t>(stack.size()))
+            return false;
+        offsets[ip - top] = a.here();
+        int d = static_cast<int>(stack.size());
+
+        switch (ins.op) {
+            case OpCode::CONSTANT: {
+                const Value& v = chunk.constants[ins.a];
+                if (v.type == ValueType::NUMBER) a.constant(d, v.number);
+                else if (v.type == ValueType::BOOLEAN) a.constant(d, v.boolean ? 1.0 : 0.0);
+                else return false;
+                stack.push_back(v.type);
+                break;
+            }
+
+            case OpCode::LOAD: {
+                ValueType type = slotType(ins.a, false);
+                if (type == ValueType::NUMBER) a.loadNumber(d, RDI, slotOffset(ins.a));
+                else if (type == ValueType::BOOLEAN) a.loadBool(d, RDI, slotOffset(ins.a));
+                else return false;
+                stack.push_back(type);
+                break;
+            }
+
+            case OpCode::LOAD_COUNTER:
+                if (ins.b + 3 > loop.depth) return false;
+                a.loadNumber(d, RSI, stackOffset(ins.b));
+                stack.push_back(ValueType::NUMBER);
+                break;
+
+            case OpCode::STORE: {
+                if (ins.flags & STORE_CONSTANT) return false;
+                if (slotType(ins.a, true) != stack.back()) return false;
+                if (stack.back() == ValueType::NUMBER) a.storeNumber(RDI, slotOffset(ins.a), d - 1);
+                else a.storeBool(RDI, slotOffset(ins.a), d - 1);
+                stack.pop_back();
+                break;
+            }
+
+            case OpCode::ADD:
+                if (stack[d - 2] != ValueType::NUMBER || stack[d - 1] != ValueType::NUMBER) return false;
+                a.add(d - 2, d - 1);
+                stack.pop_back();
+                break;
+
+            case OpCode::EQUAL:
+                if (stack[d - 2] != stack[d - 1]) {
+                    a.clear(d - 2);
+                } else {
+                    a.compare(d - 2, d - 1);
+                    a.setEqual(d - 2);
+                }
+                stack[d - 2] = ValueType::BOOLEAN;
+                stack.pop_back();
+                break;
+
+            case OpCode::JUMP_IF_FALSE:
+                if (stack.back() != ValueType::BOOLEAN) return false;
+                stack.pop_back();
+                a.clear(Zero);
+                a.compare(d - 1, Zero);
+                branch(a.jumpIf(CC_E), ins.b);
+                break;
+
+            case OpCode::JUMP_UNLESS_TRUE:
+                if (stack.back() == ValueType::BOOLEAN) {
+                    stack.pop_back();
+                    a.clear(Zero);
+                    a.compare(d - 1, Zero);
+                    branch(a.jumpIf(CC_E), ins.b);
+                } else {
+                    stack.pop_back();
+                    branch(a.jump(), ins.b);
+                }
+                break;
+
+            case OpCode::JUMP:
+                if (ip != backEdge || ins.b != top || !stack.empty()) return false;
+                a.patch(a.jump(), offsets[0]);
+                break;
+
+            case OpCode::FOR_LOOP: {
+                if (ip != backEdge || ins.b != top || !stack.empty() || !(ins.flags & FOR_ASCENDING))
+                    return false;
+                size_t state = loop.depth - 3;
+                a.loadNumber(Counter, RSI, stackOffset(state));
+                a.loadNumber(Limit, RSI, stackOffset(state + 2));
+                a.add(Counter, Limit);
+                a.storeNumber(RSI, stackOffset(state), Counter);
+                a.loadNumber(Limit, RSI, stackOffset(state + 1));
+                a.compare(Limit, Counter);
+                exits.push_back({a.jumpIf(CC_B), backEdge + 1});
+                if (!(ins.flags & FOR_COUNTED)) {
+                    if (slotType(ins.a, true) != ValueType::NUMBER) return false;
+                    a.storeNumber(RDI, slotOffset(ins.a), Counter);
+                }
+                a.patch(a.jump(), offsets[0]);
+                break;
+            }
+
+            default:
+                return false;
+        }
+
+        if (stack.size() > MaxDepth) return false;
+    }
+
+    for (const Fixup& f : fixups)
+        a.patch(f.at, offsets[f.target - top]);
+    for (const Fixup& f : exits) {
+        a.patch(f.at, a.here());
+        a.exit(f.target);
+    }
+
+    void* memory = mmap(nullptr, a.code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return false;
+    std::memcpy(memory, a.code.data(), a.code.size());
+    if (mprotect(memory, a.code.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, a.code.size());
+        return false;
+    }
+
+    loop.code = reinterpret_cast<NativeLoop>(memory);
+    loop.codeSize = a.code.size();
+    return true;
+}
+
+} // namespace
+#endif
+
+bool Jit::available() {
+#ifdef JORGESCRIPT_JIT
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint32_t Jit::enter(Interpreter& in, const Chunk& chunk, uint32_t backEdge, uint32_t top, std::vector<Value>& stack) {
+#ifdef JORGESCRIPT_JIT
+    if (!chunk.jit) chunk.jit = std::make_shared<JitCode>();
+    Loop& loop = chunk.jit->loops[backEdge];
+
+    if (loop.state == Loop::COUNTING) {
+        if (++loop.count < HotLoop) return top;
+        loop.depth = stack.size();
+        if (compileLoop(chunk, top, backEdge, in.scopes.back(), loop)) {
+            loop.state = Loop::COMPILED;
+            in.jitStats.compiled++;
+        } else {
+            loop.state = Loop::REJECTED;
+            loop.guards.clear();
+            in.jitStats.rejected++;
+        }
+    }
+    if (loop.state != Loop::COMPILED || stack.size() != loop.depth) return top;
+
+    std::vector<Variable>& slots = in.scopes.back().slots;
+    for (const Guard& g : loop.guards) {
+        const Variable& var = slots[g.slot];
+        if (!var.defined || var.value.type != g.type || (g.stored && var.isconstant)) {
+            in.jitStats.guardFailures++;
+            return top;
+        }
+    }
+
+    in.jitStats.entries++;
+    return loop.code(slots.data(), stack.data());
+#else
+    (void)in;
+    (void)chunk;
+    (void)backEdge;
+    (void)stack;
+    return top;
+#endif
+}
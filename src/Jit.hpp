@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Bytecode.hpp"
+
+// Compiled loops of one Chunk, with the execution counts of the loops that
+// are not compiled (yet). Owned by the Chunk.
+struct JitCode;
+class Interpreter;
+
+// What the JIT did during one Interpreter's runs (--stats).
+struct JitStats {
+    uint64_t compiled = 0;
+    uint64_t rejected = 0;
+    uint64_t entries = 0;
+    uint64_t guardFailures = 0;
+};
+
+// Tiered compilation of hot loops (--jit, Interpreter::Options::jit). The VM reports every back-edge it
+// takes; once a loop has run HotLoop iterations and its body only moves
+// numbers and booleans between frame slots (`+`, `=`, IF, the FOR counter),
+// it is compiled to x86-64 code specialised on the types its slots hold at
+// that moment. Every later entry checks those types again and stays in the
+// interpreter when one of them differs.
+class Jit {
+public:
+    static constexpr uint32_t HotLoop = 100;
+
+    // Whether this build can generate code (x86-64 Linux).
+    static bool available();
+
+    // Called after the back-edge at `backEdge` jumped to `top`. Returns the
+    // instruction to continue at: after the loop when it ran natively,
+    // otherwise `top`.
+    static uint32_t enter(Interpreter& in, const Chunk& chunk, uint32_t backEdge, uint32_t top, std::vector<Value>& stack);
+};
@@ -1,22 +1,109 @@
 #include "Lexer.hpp"
-#include <cctype>
+#include "CharScan.hpp"
+#include <array>
 #include <stdexcept>
 #include <iostream>
 
-Lexer::Lexer(const std::string& src) : src(src) {}
+namespace {
+struct Keyword {
+    std::string_view spelling;
+    TokenType type;
+};
+
+constexpr Keyword Keywords[] = {
+    {"IF", TokenType::IF},
+    {"THEN", TokenType::THEN},
+    {"OR", TokenType::OR},
+    {"IS", TokenType::IS},
+    {"ISNOT", TokenType::ISNOT},
+    {"SET", TokenType::SET},
+    {"TO", TokenType::TO},
+    {"ALWAYS", TokenType::ALWAYS},
+    {"PRINT", TokenType::PRINT},
+    {"AS", TokenType::AS},
+    {"LOADDLL", TokenType::LOADDLL_TOKEN},
+    {"CALL", TokenType::CALL_TOKEN},
+    {"DECLARE", TokenType::DECLARE},
+    {"INSIDE", TokenType::INSIDE},
+    {"SUMMON", TokenType::SUMMON},
+    {"FOR", TokenType::FOR},
+    {"STEP", TokenType::STEP},
+    {"WHILE", TokenType::WHILE},
+    {"PARALLEL", TokenType::PARALLEL},
+    {"REDUCE", TokenType::REDUCE},
+    {"ASYNC", TokenType::ASYNC},
+    {"AWAIT", TokenType::AWAIT},
+    {"ARRAY", TokenType::ARRAY},
+    {"LENGTH", TokenType::LENGTH},
+    {"TRUE", TokenType::TRUE},
+    {"Untrue...", TokenType::FALSE},
+    {"NOTHING", TokenType::NOTHING},
+};
+
+constexpr size_t KeywordCount = sizeof(Keywords) / sizeof(Keywords[0]);
+constexpr size_t KeywordTableSize = 64;
+
+constexpr uint32_t keywordHash(std::string_view word, uint32_t seed) {
+    uint32_t h = seed ^ static_cast<uint32_t>(word.size());
+    h = (h ^ static_cast<unsigned char>(word.front())) * 16777619u;
+    h = (h ^ static_cast<unsigned char>(word[word.size() / 2])) * 16777619u;
+    h = (h ^ static_cast<unsigned char>(word.back())) * 16777619u;
+    return (h ^ (h >> 15)) % KeywordTableSize;
+}
+
+constexpr bool isPerfect(uint32_t seed) {
+    bool used[KeywordTableSize] = {};
+    for (const Keyword& k : Keywords) {
+        uint32_t h = keywordHash(k.spelling, seed);
+        if (used[h]) return false;
+        used[h] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t findSeed() {
+    for (uint32_t seed = 2166136261u; seed < 2166136261u + 100000; seed++)
+        if (isPerfect(seed)) return seed;
+    return 0;
+}
+
+constexpr uint32_t KeywordSeed = findSeed();
+static_assert(KeywordSeed != 0, "no perfect hash seed for the keyword table");
+
+constexpr std::array<int8_t, KeywordTableSize> makeKeywordTable() {
+    std::array<int8_t, KeywordTableSize> table{};
+    for (auto& slot : table) slot = -1;
+    for (size_t i = 0; i < KeywordCount; i++)
+        table[keywordHash(Keywords[i].spelling, KeywordSeed)] = static_cast<int8_t>(i);
+    return table;
+}
+
+constexpr std::array<int8_t, KeywordTableSize> KeywordTable = makeKeywordTable();
+
+TokenType lookupKeyword(std::string_view word) {
+    int8_t index = KeywordTable[keywordHash(word, KeywordSeed)];
+    if (index >= 0 && Keywords[index].spelling == word)
+        return Keywords[index].type;
+    return TokenType::IDENT;
+}
+
+} // namespace
+
+Lexer::Lexer(std::string_view src) : src(src) {}
 
 Token Lexer::next() {
     skipWhitespace();
+    start = pos;
 
     if (pos >= src.size())
         return {TokenType::END, ""};
 
     char c = src[pos];
 
-    if (std::isalpha(c))
+    if (charscan::is(c, charscan::ALPHA))
         return identifier();
 
-    if (std::isdigit(c))
+    if (charscan::is(c, charscan::DIGIT))
         return number();
 
     if (c == '"')
@@ -36,6 +123,8 @@ Token Lexer::next() {
         case ')': return {TokenType::RPAREN, ")"};
         case '{': return {TokenType::LBRACE, "{"};
         case '}': return {TokenType::RBRACE, "}"};
+        case '[': return {TokenType::LBRACKET, "["};
+        case ']': return {TokenType::RBRACKET, "]"};
         case ';': return {TokenType::SEMICOLON, ";"};
         case '+': return {TokenType::PLUS, "+"};
         case ',': return {TokenType::COMMA, ","};
@@ -51,16 +140,16 @@ char Lexer::peek() const {
 }
 
 void Lexer::skipWhitespace() {
-    while (pos < src.size() && std::isspace(src[pos]))
-        pos++;
+    if (pos >= src.size()) return;
+    pos = charscan::skipSpace(src.data() + pos, src.data() + src.size()) - src.data();
 }
 
 Token Lexer::identifier() {
-    size_t start = pos;
-    while (pos < src.size() && (std::isalnum(src[pos]) || src[pos]=='.' || src[pos]=='_'))
-        pos++;
-
-    std::string word = src.substr(start, pos - start);
+    bool lower = false;
+    const char* begin = src.data() + pos;
+    const char* end = charscan::scanIdentifier(begin, src.data() + src.size(), lower);
+    std::string_view word(begin, end - begin);
+    pos += word.size();
 
     bool bang = false;
     if (pos < src.size() && src[pos] == '!') {
@@ -68,46 +157,32 @@ Token Lexer::identifier() {
         pos++;
     }
 
-    std::cout << "Identifier found: " << word << (bang ? "!" : "") << "\n";
+    if (trace)
+        std::cout << "Identifier found: " << word << (bang ? "!" : "") << "\n";
+
+    TokenType type = lookupKeyword(word);
 
-    if (word == "TRUE") {
+    if (type == TokenType::TRUE) {
         if (!bang)
             throw std::runtime_error("TRUE must be TRUE!");
         return {TokenType::TRUE, "TRUE!"};
     }
-    if (word == "Untrue...") {
+    if (type == TokenType::FALSE) {
         if (bang)
             throw std::runtime_error("Unexpected !");
         return {TokenType::FALSE, "Untrue..."};
     }
-    if (word == "NOTHING") {
+    if (type == TokenType::NOTHING) {
         return {TokenType::NOTHING, "NOTHING"};
     }
 
-    if (!allowLowercase)
-        for (char ch : word)
-            if (std::islower((unsigned char)ch))
-                throw std::runtime_error("Lowercase not allowed");
+    if (!allowLowercase && lower)
+        throw std::runtime_error("Lowercase not allowed");
 
     allowLowercase = false;
 
-    if (word == "IF") return {TokenType::IF, word};
-    if (word == "THEN") return {TokenType::THEN, word};
-    if (word == "OR") return {TokenType::OR, word};
-    if (word == "IS") return {TokenType::IS, word};
-    if (word == "ISNOT") return {TokenType::ISNOT, word};
-    if (word == "SET") return {TokenType::SET, word};
-    if (word == "TO") return {TokenType::TO, word};
-    if (word == "ALWAYS") return {TokenType::ALWAYS, word};
-    if (word == "PRINT") return {TokenType::PRINT, word};
-    if (word == "AS") return {TokenType::AS, word};
-    if (word == "LOADDLL") return {TokenType::LOADDLL_TOKEN, word};
-    if (word == "CALL") return {TokenType::CALL_TOKEN, word};
-    if (word == "INSIDE") return {TokenType::INSIDE, word};
-    if (word == "SUMMON") return {TokenType::SUMMON, word};
-    if (word == "FOR") return {TokenType::FOR, word};
-    if (word == "STEP") return {TokenType::STEP, word};
-    if (word == "WHILE") return {TokenType::WHILE, word};
+    if (type != TokenType::IDENT)
+        return {type, word};
 
     if (bang)
         throw std::runtime_error("Unexpected !");
@@ -116,21 +191,20 @@ Token Lexer::identifier() {
 
 Token Lexer::number() {
     size_t start = pos;
+    const char* end = src.data() + src.size();
     if (src[pos] == '0' && (pos+1 < src.size()) && (src[pos+1] == 'x' || src[pos+1] == 'X')) {
-        pos += 2;
-        while (pos < src.size() && std::isxdigit(src[pos])) pos++;
+        pos = charscan::scanHex(src.data() + pos + 2, end) - src.data();
         return {TokenType::NUMBER, src.substr(start, pos - start)};
     }
-    while (pos < src.size() && (std::isdigit(src[pos]) || src[pos] == '.')) pos++;
+    pos = charscan::scanNumber(src.data() + pos, end) - src.data();
     return {TokenType::NUMBER, src.substr(start, pos - start)};
 }
 
 Token Lexer::string() {
     pos++;
     size_t start = pos;
-    while (pos < src.size() && src[pos] != '"')
-        pos++;
-    std::string value = src.substr(start, pos - start);
+    pos = charscan::findQuote(src.data() + pos, src.data() + src.size()) - src.data();
+    std::string_view value = src.substr(start, pos - start);
     pos++;
     return {TokenType::STRING, value};
 }
@@ -1,5 +1,5 @@
 #pragma once
-#include <string>
+#include <string_view>
 
 enum class TokenType {
     IF, THEN, OR,
@@ -8,7 +8,7 @@ enum class TokenType {
     SET, TO, ALWAYS,
     PLUS, PRINT,
     AS, COMMA,
-    LOADDLL_TOKEN, CALL_TOKEN,
+    LOADDLL_TOKEN, CALL_TOKEN, DECLARE,
     AMPERSAND, ASTERISK,
 
     TRUE, FALSE, NOTHING,
@@ -20,30 +20,44 @@ enum class TokenType {
     EQUAL,
     LPAREN, RPAREN,
     LBRACE, RBRACE,
+    LBRACKET, RBRACKET,
     SEMICOLON,
 
     FOR, STEP, WHILE,
+    PARALLEL, REDUCE,
+    ASYNC, AWAIT,
+    ARRAY, LENGTH,
 
     INSIDE, SUMMON,
 
     END
 };
 
+// `value` points into the source buffer (or a static keyword spelling);
+// the parser copies it only when a node has to keep the text.
 struct Token {
     TokenType type;
-    std::string value;
+    std::string_view value;
 };
 
 class Lexer {
 public:
-    explicit Lexer(const std::string& src);
+    explicit Lexer(std::string_view src);
     Token next();
 
+    // Offset of the last token returned by next() within the source.
+    size_t offset() const { return start; }
+    std::string_view source() const { return src; }
+
     bool allowLowercase = false;
 
+    // Echo every identifier to stdout while lexing (--trace-lexer).
+    static inline bool trace = false;
+
 private:
-    std::string src;
+    std::string_view src;
     size_t pos = 0;
+    size_t start = 0;
 
     char peek() const;
     void skipWhitespace();
@@ -0,0 +1,116 @@
+#include "Library.hpp"
+#include <type_traits>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#ifdef _WIN32
+
+LibraryHandle openLibrary(const std::string& path) {
+    return LoadLibraryA(path.c_str());
+}
+
+void* findSymbol(LibraryHandle library, const std::string& name) {
+    return reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(library), name.c_str()));
+}
+
+std::wstring utf8ToUtf16(const std::string& s) {
+    if (s.empty()) return {};
+    int size = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, nullptr, 0);
+    std::wstring result(size, 0);
+    MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, &result[0], size);
+    result.pop_back();
+    return result;
+}
+
+#else
+
+LibraryHandle openLibrary(const std::string& path) {
+    return dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+}
+
+void* findSymbol(LibraryHandle library, const std::string& name) {
+    return dlsym(library, name.c_str());
+}
+
+#endif
+
+namespace {
+// Integer-class and double arguments go in separate register files, so a
+// prototype is fully determined by the return type, the arity and a mask
+// of which arguments are doubles. One trampoline is instantiated for each.
+template <unsigned Mask, size_t I>
+using ArgType = std::conditional_t<((Mask >> I) & 1) != 0, double, int64_t>;
+
+template <unsigned Mask, size_t I>
+ArgType<Mask, I> argument(const FfiSlot* args) {
+    if constexpr (((Mask >> I) & 1) != 0)
+        return args[I].d;
+    else
+        return args[I].i;
+}
+
+template <typename R, unsigned Mask, size_t... I>
+void invoke(void* fn, const FfiSlot* args, FfiSlot* ret, std::index_sequence<I...>) {
+    using Fn = R (*)(ArgType<Mask, I>...);
+    Fn f = reinterpret_cast<Fn>(fn);
+    if constexpr (std::is_void_v<R>) {
+        f(argument<Mask, I>(args)...);
+    } else if constexpr (std::is_same_v<R, double>) {
+        ret->d = f(argument<Mask, I>(args)...);
+    } else {
+        ret->i = static_cast<int64_t>(f(argument<Mask, I>(args)...));
+    }
+}
+
+template <typename R, size_t Arity, unsigned Mask>
+void trampoline(void* fn, const FfiSlot* args, FfiSlot* ret) {
+    invoke<R, Mask>(fn, args, ret, std::make_index_sequence<Arity>{});
+}
+
+// Trampolines of every arity are laid out back to back: arity n starts at
+// index 2^n - 1 and is followed by its 2^n masks.
+constexpr size_t TableSize = (size_t(1) << (MaxFfiArgs + 1)) - 1;
+
+constexpr size_t arityAt(size_t index) {
+    size_t arity = 0;
+    while ((size_t(2) << arity) <= index + 1) arity++;
+    return arity;
+}
+
+constexpr unsigned maskAt(size_t index) {
+    return static_cast<unsigned>(index + 1 - (size_t(1) << arityAt(index)));
+}
+
+template <typename R, size_t... Index>
+constexpr std::array<Trampoline, TableSize> makeTable(std::index_sequence<Index...>) {
+    return {{&trampoline<R, arityAt(Index), maskAt(Index)>...}};
+}
+
+template <typename R>
+constexpr std::array<Trampoline, TableSize> Table = makeTable<R>(std::make_index_sequence<TableSize>{});
+
+} // namespace
+
+Trampoline findTrampoline(FfiType ret, const FfiType* args, size_t arity) {
+    if (arity > MaxFfiArgs) return nullptr;
+
+    unsigned mask = 0;
+    for (size_t i = 0; i < arity; i++)
+        if (args[i] == FfiType::DOUBLE) mask |= 1u << i;
+    size_t index = (size_t(1) << arity) - 1 + mask;
+
+    switch (ret) {
+        case FfiType::VOID:   return Table<void>[index];
+        case FfiType::BOOL:   return Table<bool>[index];
+        case FfiType::INT:    return Table<int32_t>[index];
+        case FfiType::DOUBLE: return Table<double>[index];
+        default:              return Table<int64_t>[index];
+    }
+}
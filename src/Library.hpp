@@ -0,0 +1,57 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#define JORGESCRIPT_STDCALL __stdcall
+#else
+#define JORGESCRIPT_STDCALL
+#endif
+
+// Functions called through CALL without a DECLARE take the argument count
+// and an array of pointer-sized arguments: numbers and booleans by value,
+// strings as a pointer to NUL-terminated text (UTF-16 on Windows, UTF-8
+// elsewhere), arrays as a pointer to their doubles. Arrays are not copied
+// (a DECLAREd PTR takes them the same way), so what the function writes
+// into one is seen by every value that shares it.
+using LibraryFunction = int (JORGESCRIPT_STDCALL*)(int, void**);
+
+// Argument and return types of a DECLAREd function.
+enum class FfiType : uint8_t { VOID, BOOL, INT, INT64, DOUBLE, PTR, STRING };
+
+// One marshalled argument or return value. Everything but DOUBLE travels
+// as a 64-bit integer, which is also how pointers are passed on the 64-bit
+// ABIs this targets.
+union FfiSlot {
+    int64_t i;
+    double d;
+};
+
+constexpr size_t MaxFfiArgs = 6;
+
+// Calls `fn` with the C prototype the signature describes.
+using Trampoline = void (*)(void* fn, const FfiSlot* args, FfiSlot* ret);
+
+struct FfiSignature {
+    FfiType ret = FfiType::VOID;
+    uint8_t arity = 0;
+    std::array<FfiType, MaxFfiArgs> args{};
+    Trampoline trampoline = nullptr;
+};
+
+// Picks the trampoline instantiated for this return type and arity and for
+// which of the arguments are doubles.
+Trampoline findTrampoline(FfiType ret, const FfiType* args, size_t arity);
+
+// Shared libraries through dlopen/dlsym on POSIX and
+// LoadLibraryA/GetProcAddress on Windows.
+using LibraryHandle = void*;
+
+LibraryHandle openLibrary(const std::string& path);
+void* findSymbol(LibraryHandle library, const std::string& name);
+
+#ifdef _WIN32
+std::wstring utf8ToUtf16(const std::string& s);
+#endif
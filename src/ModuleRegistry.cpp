@@ -0,0 +1,160 @@
+#include "ModuleRegistry.hpp"
+#include "Compiler.hpp"
+#include "Runtime.hpp"
+#include "ThreadPool.hpp"
+#include <filesystem>
+#include <mutex>
+#include <unordered_set>
+
+namespace {
+std::string canonicalPath(const std::string& filename) {
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(filename, ec);
+    return ec ? filename : canonical.string();
+}
+
+// False when the file is gone.
+bool stamp(const std::string& path, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    auto modified = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    auto bytes = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    size = static_cast<uint64_t>(bytes);
+    mtime = static_cast<int64_t>(modified.time_since_epoch().count());
+    return true;
+}
+
+} // namespace
+
+const Chunk& Module::compiled(bool profile) {
+    if (!chunk || profiled != profile) {
+        chunk = std::make_unique<Chunk>(Compiler(profile).compile(program));
+        profiled = profile;
+    }
+    return *chunk;
+}
+
+Module& ModuleRegistry::get(std::string_view filename) {
+    auto seen = spellings.find(filename);
+    if (seen != spellings.end()) {
+        hitCount++;
+        if (trace) trace->insert(seen->second->path);
+        return *seen->second;
+    }
+
+    std::string spelled(filename);
+    std::string key = canonicalPath(spelled);
+    if (trace) trace->insert(key);
+
+    auto it = modules.find(key);
+    if (it != modules.end()) {
+        hitCount++;
+        spellings.emplace(spelled, it->second.get());
+        return *it->second;
+    }
+
+    auto module = std::make_unique<Module>();
+    module->path = key;
+    stamp(key, module->size, module->mtime);
+    module->program = parseFile(spelled);
+    missCount++;
+
+    Module* m = module.get();
+    modules.emplace(key, std::move(module));
+    spellings.emplace(spelled, m);
+    return *m;
+}
+
+void ModuleRegistry::clear() {
+    spellings.clear();
+    modules.clear();
+    hitCount = missCount = prefetchCount = 0;
+}
+
+void ModuleRegistry::refresh() {
+    spellings.clear();
+    for (auto it = modules.begin(); it != modules.end();) {
+        const Module& m = *it->second;
+        uint64_t size;
+        int64_t mtime;
+        if (stamp(m.path, size, mtime) && size == m.size && mtime == m.mtime)
+            ++it;
+        else
+            it = modules.erase(it);
+    }
+    hitCount = missCount = prefetchCount = 0;
+}
+
+bool ModuleRegistry::reload(const std::string& path) {
+    auto it = modules.find(path);
+    if (it == modules.end()) return false;
+
+    Module& m = *it->second;
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    stamp(path, size, mtime);
+    m.program = parseFile(path);
+    m.chunk.reset();
+    m.size = size;
+    m.mtime = mtime;
+    return true;
+}
+
+void ModuleRegistry::prefetch(const Program& entry, size_t threads) {
+    if (entry.imports.empty()) return;
+
+    std::mutex mutex;
+    std::unordered_set<std::string> claimed;
+    std::vector<std::pair<std::string, std::unique_ptr<Module>>> loaded;
+    // Spellings of modules that another task claimed first.
+    std::vector<std::string> aliases;
+
+    for (const auto& [key, module] : modules)
+        claimed.insert(key);
+
+    ThreadPool pool(threads);
+
+    std::function<void(std::string)> load = [&](std::string spelled) {
+        std::string key = canonicalPath(spelled);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!claimed.insert(key).second) {
+                aliases.push_back(std::move(spelled));
+                return;
+            }
+        }
+
+        auto module = std::make_unique<Module>();
+        module->path = key;
+        stamp(key, module->size, module->mtime);
+        try {
+            module->program = parseFile(spelled);
+        } catch (const std::exception&) {
+            return;
+        }
+
+        for (std::string_view import : module->program.imports)
+            pool.submit([&load, next = std::string(import)] { load(next); });
+
+        std::lock_guard<std::mutex> lock(mutex);
+        loaded.emplace_back(std::move(spelled), std::move(module));
+    };
+
+    for (std::string_view import : entry.imports)
+        pool.submit([&load, next = std::string(import)] { load(next); });
+    pool.wait();
+
+    for (auto& [spelled, module] : loaded) {
+        Module* m = module.get();
+        modules.emplace(m->path, std::move(module));
+        spellings.emplace(std::move(spelled), m);
+        prefetchCount++;
+    }
+    for (std::string& spelled : aliases) {
+        if (spellings.count(spelled)) continue;
+        auto it = modules.find(canonicalPath(spelled));
+        if (it != modules.end())
+            spellings.emplace(std::move(spelled), it->second.get());
+    }
+}
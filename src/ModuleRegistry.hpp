@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+#include "AST.hpp"
+#include "Bytecode.hpp"
+
+// A SUMMONed script, parsed once per Interpreter. The bytecode is compiled
+// the first time the VM runs the module, and again if profiling was switched
+// since (the profiler has instructions of its own).
+struct Module {
+    std::string path;
+    Program program;
+    std::unique_ptr<Chunk> chunk;
+    bool profiled = false;
+    // Size and modification time of the file when it was parsed.
+    uint64_t size = 0;
+    int64_t mtime = 0;
+
+    const Chunk& compiled(bool profile);
+};
+
+// Owns every module an Interpreter SUMMONed, keyed by canonical path, so a
+// SUMMON inside a loop (or the same library summoned from several scripts)
+// reads and parses the file only once. Only parsing is shared: each SUMMON
+// still executes the module's statements again in a fresh scope, exactly
+// as if the file had just been read.
+class ModuleRegistry {
+public:
+    Module& get(std::string_view filename);
+    void clear();
+    // Called between the runs of a long-lived Interpreter: drops the
+    // modules whose file changed since it was parsed, and the spellings,
+    // which may name other files from another working directory. The
+    // counters start again from zero.
+    void refresh();
+    // Parses the module at `path` (canonical) again, in place, for a --watch
+    // session. Throws, leaving the module as it was, when the new text does
+    // not parse. False when no module has that path.
+    bool reload(const std::string& path);
+
+    // Parses everything `entry` can SUMMON, directly or through other
+    // modules, on a thread pool before execution starts. Modules that fail
+    // to load are left out; the SUMMON reports the error if and when it
+    // actually runs.
+    void prefetch(const Program& entry, size_t threads);
+
+    uint64_t hits() const { return hitCount; }
+    uint64_t misses() const { return missCount; }
+    uint64_t prefetched() const { return prefetchCount; }
+
+    // While set, the path of every module SUMMONed is added to it (before
+    // parsing, so a module that fails to parse is there too).
+    std::unordered_set<std::string>* trace = nullptr;
+
+private:
+    NameMap<std::unique_ptr<Module>> modules;
+    // Spellings already seen in SUMMON statements, so repeated summons skip
+    // canonicalizing the path.
+    NameMap<Module*> spellings;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+    uint64_t prefetchCount = 0;
+};
@@ -0,0 +1,107 @@
+#include "NumArray.hpp"
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define JORGESCRIPT_ARRAY_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JORGESCRIPT_ARRAY_SSE2 1
+#endif
+
+static_assert(sizeof(NumArray) % NumArray::Alignment == 0, "elements have to start aligned");
+
+NumArray* NumArray::uninitialized(size_t count) {
+    if (count > (std::numeric_limits<size_t>::max() - sizeof(NumArray)) / sizeof(double))
+        throw std::runtime_error("Array too large");
+    void* memory = ::operator new(sizeof(NumArray) + count * sizeof(double), std::align_val_t(Alignment));
+    NumArray* array = new (memory) NumArray();
+    array->count = count;
+    return array;
+}
+
+NumArray* NumArray::make(size_t count) {
+    NumArray* array = uninitialized(count);
+    std::memset(array->data(), 0, count * sizeof(double));
+    return array;
+}
+
+NumArray* NumArray::clone() const {
+    NumArray* copy = uninitialized(count);
+    std::memcpy(copy->data(), data(), count * sizeof(double));
+    return copy;
+}
+
+void NumArray::destroy(NumArray* array) {
+    array->~NumArray();
+    ::operator delete(array, std::align_val_t(Alignment));
+}
+
+namespace numkernels {
+
+void add(double* out, const double* a, const double* b, size_t n) {
+    size_t i = 0;
+#if JORGESCRIPT_ARRAY_AVX2
+    for (; i + 4 <= n; i += 4)
+        _mm256_store_pd(out + i, _mm256_add_pd(_mm256_load_pd(a + i), _mm256_load_pd(b + i)));
+#elif JORGESCRIPT_ARRAY_SSE2
+    for (; i + 2 <= n; i += 2)
+        _mm_store_pd(out + i, _mm_add_pd(_mm_load_pd(a + i), _mm_load_pd(b + i)));
+#endif
+    for (; i < n; i++)
+        out[i] = a[i] + b[i];
+}
+
+void addScalar(double* out, const double* a, double s, size_t n) {
+    size_t i = 0;
+#if JORGESCRIPT_ARRAY_AVX2
+    __m256d splat = _mm256_set1_pd(s);
+    for (; i + 4 <= n; i += 4)
+        _mm256_store_pd(out + i, _mm256_add_pd(_mm256_load_pd(a + i), splat));
+#elif JORGESCRIPT_ARRAY_SSE2
+    __m128d splat = _mm_set1_pd(s);
+    for (; i + 2 <= n; i += 2)
+        _mm_store_pd(out + i, _mm_add_pd(_mm_load_pd(a + i), splat));
+#endif
+    for (; i < n; i++)
+        out[i] = a[i] + s;
+}
+
+bool equal(const double* a, const double* b, size_t n) {
+    size_t i = 0;
+#if JORGESCRIPT_ARRAY_AVX2
+    for (; i + 4 <= n; i += 4)
+        if (_mm256_movemask_pd(_mm256_cmp_pd(_mm256_load_pd(a + i), _mm256_load_pd(b + i), _CMP_EQ_OQ)) != 0xF)
+            return false;
+#elif JORGESCRIPT_ARRAY_SSE2
+    for (; i + 2 <= n; i += 2)
+        if (_mm_movemask_pd(_mm_cmpeq_pd(_mm_load_pd(a + i), _mm_load_pd(b + i))) != 0x3)
+            return false;
+#endif
+    for (; i < n; i++)
+        if (!(a[i] == b[i])) return false;
+    return true;
+}
+
+bool equalScalar(const double* a, double s, size_t n) {
+    size_t i = 0;
+#if JORGESCRIPT_ARRAY_AVX2
+    __m256d splat = _mm256_set1_pd(s);
+    for (; i + 4 <= n; i += 4)
+        if (_mm256_movemask_pd(_mm256_cmp_pd(_mm256_load_pd(a + i), splat, _CMP_EQ_OQ)) != 0xF)
+            return false;
+#elif JORGESCRIPT_ARRAY_SSE2
+    __m128d splat = _mm_set1_pd(s);
+    for (; i + 2 <= n; i += 2)
+        if (_mm_movemask_pd(_mm_cmpeq_pd(_mm_load_pd(a + i), splat)) != 0x3)
+            return false;
+#endif
+    for (; i < n; i++)
+        if (!(a[i] == s)) return false;
+    return true;
+}
+
+} // namespace numkernels
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Reference-counted run of doubles behind an array value. The elements
+// follow the header, 32-byte aligned, so the kernels below can use aligned
+// vector loads and foreign code can take them as a plain double*.
+//
+// Values share arrays the way they share Ropes. `SET A[I] TO x` writes in
+// place only while A holds the sole reference and copies the array first
+// otherwise, so an array another variable still holds never changes.
+class alignas(32) NumArray {
+public:
+    static constexpr size_t Alignment = 32;
+
+    // Zero-filled.
+    static NumArray* make(size_t count);
+    // For kernels that write every element.
+    static NumArray* uninitialized(size_t count);
+    NumArray* clone() const;
+
+    void retain() { refs++; }
+    void release() {
+        if (--refs == 0) destroy(this);
+    }
+    bool shared() const { return refs > 1; }
+
+    size_t size() const { return count; }
+    double* data() { return reinterpret_cast<double*>(this + 1); }
+    const double* data() const { return reinterpret_cast<const double*>(this + 1); }
+
+private:
+    NumArray() = default;
+
+    static void destroy(NumArray* array);
+
+    uint32_t refs = 1;
+    size_t count = 0;
+};
+
+// Element-wise kernels for `+` and `=` on arrays, four doubles at a time
+// with AVX2, two with SSE2 and one by one otherwise. Every pointer comes
+// from NumArray::data(), so all of them are aligned.
+namespace numkernels {
+
+void add(double* out, const double* a, const double* b, size_t n);
+void addScalar(double* out, const double* a, double s, size_t n);
+// Whether a[i] == b[i] (or s) for every i; NaN equals nothing.
+bool equal(const double* a, const double* b, size_t n);
+bool equalScalar(const double* a, double s, size_t n);
+
+} // namespace numkernels
@@ -0,0 +1,266 @@
+#include "Optimizer.hpp"
+#include "AstPrinter.hpp"
+#include "Runtime.hpp"
+#include <ostream>
+#include <stdexcept>
+
+void Optimizer::optimize(Program& program) {
+    if (dump) {
+        *dump << "-- parsed\n";
+        AstPrinter(*dump).block(program.statements);
+    }
+
+    const StatementList& body = program.statements;
+    std::vector<uint32_t> summonsThrough(body.size());
+    for (size_t i = 0; i < body.size(); i++) {
+        body[i]->collect(*this);
+        summonsThrough[i] = summons;
+    }
+
+    for (size_t i = 0; i < body.size(); i++) {
+        summonsAhead = summons - summonsThrough[i];
+        body[i]->optimize(*this);
+    }
+    program.statements = arena.list(pending.data(), pending.size());
+    pending.clear();
+
+    if (dump) {
+        *dump << "-- optimized\n";
+        AstPrinter(*dump).block(program.statements);
+        *dump << "-- " << counts.folded << " folded, " << counts.inlined << " constants inlined, "
+              << counts.removed << " blocks removed, " << counts.unwrapped << " IFs unwrapped\n";
+    }
+}
+
+StatementList Optimizer::block(const StatementList& body) {
+    size_t mark = pending.size();
+    depth++;
+    for (Statement* stmt : body)
+        stmt->optimize(*this);
+    depth--;
+
+    StatementList out = arena.list(pending.data() + mark, pending.size() - mark);
+    pending.resize(mark);
+    return out;
+}
+
+void Optimizer::assigned(std::string_view name, uint32_t times) {
+    auto it = assignments.find(name);
+    if (it == assignments.end())
+        assignments.emplace(std::string(name), times);
+    else
+        it->second += times;
+}
+
+Expr* Optimizer::literal(Value value) {
+    auto lit = arena.make<LiteralExpr>();
+    lit->value = std::move(value);
+    return lit;
+}
+
+Expr* Optimizer::constant(std::string_view name) {
+    auto it = constants.find(name);
+    if (it == constants.end())
+        return nullptr;
+    counts.inlined++;
+    return literal(it->second);
+}
+
+void Optimizer::define(const SetStatement& stmt) {
+    if (depth > 0 || !stmt.isconstant)
+        return;
+    if (!stmt.isLocal && summonsAhead > 0)
+        return;
+
+    auto it = assignments.find(stmt.name);
+    if (it == assignments.end() || it->second != 1)
+        return;
+
+    if (LiteralExpr* value = stmt.expr->asLiteral())
+        constants.emplace(std::string(stmt.name), value->value);
+}
+
+void Statement::optimize(Optimizer& o) {
+    o.emit(this);
+}
+
+Expr* VariableExpr::fold(Optimizer& o) {
+    Expr* value = o.constant(name);
+    return value ? value : this;
+}
+
+Expr* BinaryExpr::fold(Optimizer& o) {
+    left = left->fold(o);
+    right = right->fold(o);
+    if (!left->asLiteral() || !right->asLiteral())
+        return this;
+
+    // Operands that do not add up are left for the run time to report.
+    // Evaluating the node itself would quicken it for literal types.
+    const Value& l = left->asLiteral()->value;
+    const Value& r = right->asLiteral()->value;
+    Value value;
+    try {
+        if (op == '+') value = addValues(l, r);
+        else if (op == '=') value = equalValues(l, r);
+        else return this;
+    } catch (const std::runtime_error&) {
+        return this;
+    }
+    o.folded();
+    return o.literal(std::move(value));
+}
+
+Expr* ArrayExpr::fold(Optimizer& o) {
+    for (Expr*& expr : elements)
+        expr = expr->fold(o);
+    if (size)
+        size = size->fold(o);
+    return this;
+}
+
+Expr* IndexExpr::fold(Optimizer& o) {
+    array = array->fold(o);
+    index = index->fold(o);
+    return this;
+}
+
+Expr* LengthExpr::fold(Optimizer& o) {
+    value = value->fold(o);
+    return this;
+}
+
+Expr* CallDllExpr::fold(Optimizer& o) {
+    for (Expr*& arg : args)
+        arg = arg->fold(o);
+    return this;
+}
+
+void SetStatement::collect(Optimizer& o) {
+    o.assigned(name);
+}
+
+void SetStatement::optimize(Optimizer& o) {
+    expr = expr->fold(o);
+    o.define(*this);
+    o.emit(this);
+}
+
+void SetElementStatement::collect(Optimizer& o) {
+    o.assigned(name);
+}
+
+void SetElementStatement::optimize(Optimizer& o) {
+    index = index->fold(o);
+    expr = expr->fold(o);
+    o.emit(this);
+}
+
+void PrintStatement::optimize(Optimizer& o) {
+    expr = expr->fold(o);
+    o.emit(this);
+}
+
+void IfStatement::collect(Optimizer& o) {
+    for (Statement* stmt : body)
+        stmt->collect(o);
+}
+
+void IfStatement::optimize(Optimizer& o) {
+    condition = condition->fold(o);
+
+    // A literal that is not a boolean still has to fail at run time.
+    LiteralExpr* lit = condition->asLiteral();
+    if (lit && lit->value.type == ValueType::BOOLEAN) {
+        if (!lit->value.boolean) {
+            o.removed();
+            return;
+        }
+        o.unwrapped();
+        for (Statement* stmt : o.block(body))
+            o.emit(stmt);
+        return;
+    }
+
+    body = o.block(body);
+    o.emit(this);
+}
+
+void CallDllStatement::optimize(Optimizer& o) {
+    call->fold(o);
+    o.emit(this);
+}
+
+void AsyncCallStatement::collect(Optimizer& o) {
+    o.assigned(name);
+}
+
+void AsyncCallStatement::optimize(Optimizer& o) {
+    call->fold(o);
+    o.emit(this);
+}
+
+Expr* AwaitExpr::fold(Optimizer& o) {
+    handle = handle->fold(o);
+    return this;
+}
+
+void AwaitStatement::optimize(Optimizer& o) {
+    await->fold(o);
+    o.emit(this);
+}
+
+void SummonStatement::collect(Optimizer& o) {
+    o.summoned();
+}
+
+void WhileStatement::collect(Optimizer& o) {
+    for (Statement* stmt : body)
+        stmt->collect(o);
+}
+
+void WhileStatement::optimize(Optimizer& o) {
+    condition = condition->fold(o);
+
+    LiteralExpr* lit = condition->asLiteral();
+    if (lit && !lit->value.isTrue()) {
+        o.removed();
+        return;
+    }
+
+    body = o.block(body);
+    o.emit(this);
+}
+
+void ForStatement::collect(Optimizer& o) {
+    // The loop rebinds its variable every iteration and erases it after.
+    o.assigned(varName, 2);
+    for (Statement* stmt : body)
+        stmt->collect(o);
+}
+
+void ForStatement::optimize(Optimizer& o) {
+    startExpr = startExpr->fold(o);
+    endExpr = endExpr->fold(o);
+    if (stepExpr)
+        stepExpr = stepExpr->fold(o);
+    body = o.block(body);
+    o.emit(this);
+}
+
+void ParallelForStatement::collect(Optimizer& o) {
+    o.assigned(varName, 2);
+    for (std::string_view name : reductions)
+        o.assigned(name, 2);
+    for (Statement* stmt : body)
+        stmt->collect(o);
+}
+
+void ParallelForStatement::optimize(Optimizer& o) {
+    startExpr = startExpr->fold(o);
+    endExpr = endExpr->fold(o);
+    if (stepExpr)
+        stepExpr = stepExpr->fold(o);
+    body = o.block(body);
+    o.emit(this);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+#include "AST.hpp"
+
+// Rewrites a parsed Program before it is resolved:
+//  - `+` and `=` on literals are folded into one literal,
+//  - reads of an ALWAYS constant whose value is a literal are replaced by
+//    that literal,
+//  - IF and WHILE blocks whose condition is a literal are dropped when they
+//    can never run; an IF that always runs is replaced by its body.
+//
+// Scoping is dynamic, so a constant is only propagated when nothing else can
+// rebind the name after it was set: the program assigns it exactly once, in
+// a top-level `ALWAYS SET` or `INSIDE ALWAYS SET`, and (for the non-local
+// form, which may have updated a caller's variable) no SUMMON runs later.
+class Optimizer {
+public:
+    static inline bool enabled = true;
+    // Where --dump-ast prints the tree before and after the rewrite.
+    static inline std::ostream* dump = nullptr;
+
+    struct Stats {
+        uint32_t folded = 0;
+        uint32_t inlined = 0;
+        uint32_t removed = 0;
+        uint32_t unwrapped = 0;
+    };
+
+    explicit Optimizer(Arena& arena) : arena(arena) {}
+
+    void optimize(Program& program);
+    const Stats& stats() const { return counts; }
+
+    StatementList block(const StatementList& body);
+    void emit(Statement* stmt) { pending.push_back(stmt); }
+
+    void assigned(std::string_view name, uint32_t times = 1);
+    void summoned() { summons++; }
+
+    Expr* literal(Value value);
+    Expr* constant(std::string_view name);
+    void define(const SetStatement& stmt);
+    // A literal condition: drop or unwrap the block it guards.
+    void removed() { counts.removed++; }
+    void unwrapped() { counts.unwrapped++; }
+    void folded() { counts.folded++; }
+
+private:
+    Arena& arena;
+    std::vector<Statement*> pending;
+    Stats counts;
+
+    NameMap<uint32_t> assignments;
+    NameMap<Value> constants;
+    uint32_t summons = 0;
+    // SUMMONs in the top-level statements after the one being rewritten.
+    uint32_t summonsAhead = 0;
+    uint32_t depth = 0;
+};
@@ -0,0 +1,57 @@
+#include "Output.hpp"
+#include <charconv>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#include <io.h>
+#define isatty _isatty
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+
+FlushPolicy Output::defaultPolicy() {
+    return isatty(fileno(stdout)) ? FlushPolicy::LINE : FlushPolicy::SIZE;
+}
+
+bool Output::parsePolicy(std::string_view name, FlushPolicy& out) {
+    if (name == "line") out = FlushPolicy::LINE;
+    else if (name == "size") out = FlushPolicy::SIZE;
+    else if (name == "exit") out = FlushPolicy::EXIT;
+    else return false;
+    return true;
+}
+
+size_t formatNumber(char* out, double v) {
+    auto result = std::to_chars(out, out + NumberBufferSize, v, std::chars_format::general, 6);
+    return static_cast<size_t>(result.ptr - out);
+}
+
+size_t formatFixed(char* out, double v) {
+    auto result = std::to_chars(out, out + NumberBufferSize, v, std::chars_format::fixed, 6);
+    return static_cast<size_t>(result.ptr - out);
+}
+
+double parseNumber(std::string_view text) {
+    const char* first = text.data();
+    const char* last = text.data() + text.size();
+
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        long long n = 0;
+        auto [ptr, ec] = std::from_chars(first + 2, last, n, 16);
+        if (ec == std::errc::result_out_of_range)
+            throw std::runtime_error("Number out of range: " + std::string(text));
+        if (ec != std::errc())
+            throw std::runtime_error("Invalid number: " + std::string(text));
+        return static_cast<double>(n);
+    }
+
+    double d = 0;
+    auto [ptr, ec] = std::from_chars(first, last, d);
+    if (ec == std::errc::result_out_of_range)
+        throw std::runtime_error("Number out of range: " + std::string(text));
+    if (ec != std::errc())
+        throw std::runtime_error("Invalid number: " + std::string(text));
+    return d;
+}
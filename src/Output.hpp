@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// When PRINT output leaves the process. LINE hands every line to the
+// terminal right away, SIZE writes in Output::Capacity chunks and EXIT keeps
+// everything until the script finishes.
+enum class FlushPolicy : uint8_t {
+    LINE,
+    SIZE,
+    EXIT
+};
+
+// Buffered destination of PRINT, one per Interpreter. Text is collected
+// here and passed to `stream` in large writes. Anything else that writes to
+// the same stream (foreign code, diagnostics) has to call flush() first so
+// lines stay in order. Without a stream the text stays here until take().
+class Output {
+public:
+    static constexpr size_t Capacity = 1 << 16;
+
+    FlushPolicy policy = FlushPolicy::SIZE;
+    std::FILE* stream = stdout;
+
+    void write(std::string_view text) {
+        if (policy == FlushPolicy::SIZE && buffer.size() + text.size() > Capacity)
+            flush();
+        buffer.append(text);
+    }
+
+    void endLine() {
+        buffer.push_back('\n');
+        if (policy == FlushPolicy::LINE)
+            sync();
+    }
+
+    void flush() {
+        if (buffer.empty() || !stream) return;
+        std::fwrite(buffer.data(), 1, buffer.size(), stream);
+        buffer.clear();
+    }
+
+    // flush() and then push stdio's own buffer out as well.
+    void sync() {
+        flush();
+        if (stream) std::fflush(stream);
+    }
+
+    std::string take() { return std::exchange(buffer, {}); }
+
+    // LINE when stdout is a terminal, SIZE otherwise.
+    static FlushPolicy defaultPolicy();
+    static bool parsePolicy(std::string_view name, FlushPolicy& out);
+
+private:
+    std::string buffer;
+};
+
+// Numbers are spelled the way the interpreter always has: PRINT uses six
+// significant digits (3.14159, 1e+20) and `+` six decimals (55.000000).
+// Both go through std::to_chars, which is locale-free.
+constexpr size_t NumberBufferSize = 328;
+size_t formatNumber(char* out, double v);
+size_t formatFixed(char* out, double v);
+// Reads a number literal the way std::stod and std::stoll did: the longest
+// number at the start of the token counts and the rest is ignored, so
+// "1.2.3" is 1.2 and "0x" is 0.
+double parseNumber(std::string_view text);
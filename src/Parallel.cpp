@@ -0,0 +1,235 @@
+#include "Interpreter.hpp"
+#include "Compiler.hpp"
+#include "Runtime.hpp"
+#include "ScriptCache.hpp"
+#include "ThreadPool.hpp"
+#include "VM.hpp"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+// A PARALLEL FOR cuts its range into at most MaxPieces runs of consecutive
+// iterations. The cut depends on the range alone, so what the loop prints
+// and adds up (float rounding included) is the same for any thread count.
+//
+// Each pool thread runs its pieces in a worker Interpreter of its own, on
+// a copy of the body (ScriptCache::copy) and of every frame. Ropes and
+// arrays are reference-counted without atomics, so nothing a worker touches
+// may share one with another thread: they are copied on the way in (on the
+// calling thread) and on the way out (on the worker).
+
+namespace {
+constexpr uint64_t MaxPieces = 256;
+// Below 2^53 integer counters are exact doubles, so piece starts can be
+// computed instead of stepped to.
+constexpr double ExactLimit = 9007199254740992.0;
+
+bool inRange(double i, double end, double step) {
+    return step > 0 ? i <= end : i >= end;
+}
+
+Value detach(const Value& v) {
+    if (v.type == ValueType::STRING) return Value(std::string(v.str()));
+    if (v.type == ValueType::ARRAY) return Value(v.array->clone());
+    return v;
+}
+
+struct Piece {
+    double first = 0;
+    uint64_t count = 0;
+    std::string output;
+    std::vector<Value> partials;
+    std::exception_ptr error;
+};
+
+// What one pool thread runs its pieces with.
+struct Lane {
+    Interpreter* in = nullptr;
+    Program body;
+    std::optional<Chunk> chunk;
+    // The frames every piece starts from; everything but the REDUCE
+    // variables is marked constant.
+    std::vector<Scope> frames;
+};
+
+// Piece k starts at the counter the sequential FOR has after stepping
+// through pieces 0..k-1, and a zero step or empty range gives no pieces.
+std::vector<Piece> split(double start, double end, double step) {
+    std::vector<Piece> pieces;
+    if (step == 0 || !inRange(start, end, step)) return pieces;
+
+    bool exact = start == std::trunc(start) && step == std::trunc(step) &&
+                 std::fabs(start) < ExactLimit && std::fabs(end) < ExactLimit && std::fabs(step) < ExactLimit;
+    uint64_t count = 0;
+    if (exact) {
+        count = static_cast<uint64_t>(std::floor((end - start) / step)) + 1;
+        while (inRange(start + static_cast<double>(count) * step, end, step)) count++;
+        while (count > 1 && !inRange(start + static_cast<double>(count - 1) * step, end, step)) count--;
+    } else {
+        for (double i = start; inRange(i, end, step); i += step) count++;
+    }
+
+    size_t n = static_cast<size_t>(std::min(count, MaxPieces));
+    pieces.resize(n);
+    double i = start;
+    for (size_t k = 0; k < n; k++) {
+        uint64_t first = count * k / n;
+        pieces[k].count = count * (k + 1) / n - first;
+        if (exact) {
+            pieces[k].first = start + static_cast<double>(first) * step;
+            continue;
+        }
+        pieces[k].first = i;
+        for (uint64_t m = 0; m < pieces[k].count; m++) i += step;
+    }
+    return pieces;
+}
+
+std::vector<Scope> readOnlyCopy(const std::vector<Scope>& scopes) {
+    std::vector<Scope> frames(scopes.size());
+    for (size_t f = 0; f < scopes.size(); f++) {
+        frames[f].names = scopes[f].names;
+        frames[f].slots.reserve(scopes[f].slots.size());
+        for (const Variable& var : scopes[f].slots)
+            frames[f].slots.push_back({detach(var.value), true, var.defined});
+    }
+    return frames;
+}
+
+Variable* findIn(std::vector<Scope>& frames, std::string_view name) {
+    for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+        if (Variable* v = it->find(name)) return v;
+    }
+    return nullptr;
+}
+
+void mergeStats(Interpreter& into, Interpreter& from) {
+    into.jitStats.compiled += from.jitStats.compiled;
+    into.jitStats.rejected += from.jitStats.rejected;
+    into.jitStats.entries += from.jitStats.entries;
+    into.jitStats.guardFailures += from.jitStats.guardFailures;
+    into.quickening.numberAdd += from.quickening.numberAdd;
+    into.quickening.stringConcat += from.quickening.stringConcat;
+    into.quickening.numberEquals += from.quickening.numberEquals;
+    into.quickening.boolEquals += from.quickening.boolEquals;
+    into.quickening.localReads += from.quickening.localReads;
+    into.quickening.generic += from.quickening.generic;
+    into.quickening.guardFailures += from.quickening.guardFailures;
+    from.jitStats = {};
+    from.quickening = {};
+}
+
+} // namespace
+
+void Interpreter::runParallel(const ParallelForStatement& loop, const Value& start, const Value& end, const Value& step) {
+    if (start.type != ValueType::NUMBER || end.type != ValueType::NUMBER || step.type != ValueType::NUMBER)
+        throw std::runtime_error("FOR loop bounds must be numbers");
+
+    std::vector<ValueType> reduced;
+    for (std::string_view name : loop.reductions) {
+        Variable* var = findVariable(name);
+        if (!var)
+            throw std::runtime_error("REDUCE variable is not set: " + std::string(name));
+        if (var->isconstant)
+            throw std::runtime_error("Cannot modify constant: " + std::string(name));
+        if (var->value.type != ValueType::NUMBER && var->value.type != ValueType::STRING)
+            throw std::runtime_error("REDUCE variable must be a number or a string: " + std::string(name));
+        reduced.push_back(var->value.type);
+    }
+
+    std::vector<Piece> pieces = split(start.number, end.number, step.number);
+    if (pieces.empty()) {
+        eraseLoopVariable(loop.slot);
+        return;
+    }
+
+    size_t threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    if (!pool || pool->size() != threads)
+        pool = std::make_unique<StealingPool>(threads);
+    if (workers.size() < threads)
+        workers.resize(threads);
+
+    std::vector<std::string> layout(scopes.back().slots.size());
+    for (const auto& [name, index] : scopes.back().names)
+        layout[index] = name;
+
+    std::vector<Lane> lanes(std::min(threads, pieces.size()));
+    for (size_t t = 0; t < lanes.size(); t++) {
+        std::unique_ptr<Interpreter>& worker = workers[t];
+        if (!worker) {
+            worker = std::make_unique<Interpreter>(Options{.out = nullptr, .flush = FlushPolicy::EXIT, .threads = 1});
+            worker->parallelWorker = true;
+        }
+        worker->options.treeWalk = options.treeWalk;
+        worker->options.jit = options.jit;
+        worker->libraries = libraries;
+        worker->signatures = signatures;
+        worker->libraryGeneration++;
+
+        Lane& lane = lanes[t];
+        lane.in = worker.get();
+        lane.body.statements = ScriptCache::copy(loop.body, lane.body.arena);
+        lane.body.slotNames = layout;
+        if (!options.treeWalk)
+            lane.chunk = Compiler().compile(lane.body);
+        lane.frames = readOnlyCopy(scopes);
+        for (std::string_view name : loop.reductions)
+            findIn(lane.frames, name)->isconstant = false;
+        worker->scopes = lane.frames;
+    }
+
+    double stride = step.number;
+    pool->run(pieces.size(), [&](size_t k, size_t t) {
+        Lane& lane = lanes[t];
+        Piece& piece = pieces[k];
+        Interpreter& in = *lane.in;
+
+        // A failed piece may have left a SUMMON's frame behind.
+        in.scopes.resize(lane.frames.size());
+        for (size_t f = 0; f < lane.frames.size(); f++)
+            in.scopes[f].slots = lane.frames[f].slots;
+        for (size_t r = 0; r < reduced.size(); r++)
+            in.findVariable(loop.reductions[r])->value =
+                reduced[r] == ValueType::NUMBER ? Value(0.0) : Value(std::string());
+
+        try {
+            double i = piece.first;
+            for (uint64_t n = 0; n < piece.count; n++, i += stride) {
+                in.setLoopVariable(loop.slot, i);
+                if (lane.chunk)
+                    VM(in).run(*lane.chunk);
+                else
+                    in.execute(lane.body.statements);
+            }
+            for (std::string_view name : loop.reductions) {
+                Variable* var = in.findVariable(name);
+                piece.partials.push_back(var ? detach(var->value) : Value());
+            }
+        } catch (...) {
+            piece.error = std::current_exception();
+        }
+        in.finishCalls();
+        piece.output = in.output.take();
+    });
+
+    for (Lane& lane : lanes) {
+        lane.in->scopes.clear();
+        mergeStats(*this, *lane.in);
+    }
+
+    for (Piece& piece : pieces) {
+        output.write(piece.output);
+        if (output.policy == FlushPolicy::LINE) output.sync();
+        if (piece.error) std::rethrow_exception(piece.error);
+    }
+
+    for (size_t r = 0; r < reduced.size(); r++) {
+        Variable* var = findVariable(loop.reductions[r]);
+        for (Piece& piece : pieces)
+            var->value = addValues(var->value, piece.partials[r]);
+    }
+    eraseLoopVariable(loop.slot);
+}
@@ -1,8 +1,8 @@
 #include "Parser.hpp"
+#include "Output.hpp"
 #include <stdexcept>
-#include <memory>
 
-Parser::Parser(Lexer& lexer) : lexer(lexer) {
+Parser::Parser(Lexer& lexer, Arena& arena) : lexer(lexer), arena(arena) {
     advance();
 }
 
@@ -16,14 +16,65 @@ void Parser::expect(TokenType type) {
     advance();
 }
 
-std::vector<std::unique_ptr<Statement>> Parser::parseProgram() {
-    std::vector<std::unique_ptr<Statement>> stmts;
-    while (current.type != TokenType::END)
-        stmts.push_back(parseStatement());
-    return stmts;
+std::string_view Parser::keep(std::string_view text) {
+    return arena.copy(text);
 }
 
-std::unique_ptr<Statement> Parser::parseStatement() {
+StatementList Parser::parseBlockUntil(TokenType end) {
+    size_t mark = pendingStatements.size();
+    while (current.type != end) {
+        Statement* stmt = parseStatement();
+        pendingStatements.push_back(stmt);
+    }
+
+    StatementList body = arena.list(pendingStatements.data() + mark, pendingStatements.size() - mark);
+    pendingStatements.resize(mark);
+    return body;
+}
+
+NodeList<Expr*> Parser::parseArgs(TokenType close) {
+    size_t mark = pendingArgs.size();
+    if(current.type != close) {
+        Expr* arg = parseExpr();
+        pendingArgs.push_back(arg);
+        while(current.type == TokenType::COMMA) {
+            advance();
+            arg = parseExpr();
+            pendingArgs.push_back(arg);
+        }
+    }
+
+    NodeList<Expr*> args = arena.list(pendingArgs.data() + mark, pendingArgs.size() - mark);
+    pendingArgs.resize(mark);
+    return args;
+}
+
+StatementList Parser::parseProgram() {
+    return parseBlockUntil(TokenType::END);
+}
+
+void Parser::locate(size_t offset) {
+    std::string_view src = lexer.source();
+    for (; scanned < offset; scanned++) {
+        if (src[scanned] == '\n') {
+            line++;
+            lineStart = scanned + 1;
+        }
+    }
+}
+
+Statement* Parser::parseStatement() {
+    locate(lexer.offset());
+    uint32_t stmtLine = line;
+    uint32_t stmtColumn = static_cast<uint32_t>(scanned - lineStart + 1);
+
+    Statement* stmt = parseStatementKind();
+    stmt->line = stmtLine;
+    stmt->column = stmtColumn;
+    return stmt;
+}
+
+Statement* Parser::parseStatementKind() {
     if(current.type == TokenType::SET || current.type == TokenType::ALWAYS)
         return parseSet();
 
@@ -39,6 +90,9 @@ std::unique_ptr<Statement> Parser::parseStatement() {
     if(current.type == TokenType::CALL_TOKEN)
         return parseCall();
 
+    if(current.type == TokenType::DECLARE)
+        return parseDeclare();
+
     if (current.type == TokenType::INSIDE)
         return parseLocalSet();
 
@@ -51,13 +105,26 @@ std::unique_ptr<Statement> Parser::parseStatement() {
     if (current.type == TokenType::FOR)
         return parseFor();
 
+    if (current.type == TokenType::PARALLEL)
+        return parseParallelFor();
+
+    if (current.type == TokenType::ASYNC)
+        return parseAsyncCall();
+
+    if (current.type == TokenType::AWAIT) {
+        auto stmt = arena.make<AwaitStatement>();
+        stmt->await = parseAwait();
+        expect(TokenType::SEMICOLON);
+        return stmt;
+    }
+
     throw std::runtime_error("Unknown statement");
 }
 
-std::unique_ptr<Statement> Parser::parseIf() {
+Statement* Parser::parseIf() {
     expect(TokenType::IF);
 
-    std::string ident = current.value;
+    std::string_view ident = keep(current.value);
     expect(TokenType::IDENT);
     expect(TokenType::COLONCOLON);
     expect(TokenType::IS);
@@ -69,19 +136,18 @@ std::unique_ptr<Statement> Parser::parseIf() {
     expect(TokenType::THEN);
     expect(TokenType::LBRACE);
 
-    auto stmt = std::make_unique<IfStatement>();
+    auto stmt = arena.make<IfStatement>();
     
-    auto varExpr = std::make_unique<VariableExpr>();
+    auto varExpr = arena.make<VariableExpr>();
     varExpr->name = ident;
 
-    auto bin = std::make_unique<BinaryExpr>();
-    bin->left = std::move(varExpr);
-    bin->right = std::move(condExpr);
+    auto bin = arena.make<BinaryExpr>();
+    bin->left = varExpr;
+    bin->right = condExpr;
     bin->op = '=';
-    stmt->condition = std::move(bin);
+    stmt->condition = bin;
 
-    while(current.type != TokenType::RBRACE)
-        stmt->body.push_back(parseStatement());
+    stmt->body = parseBlockUntil(TokenType::RBRACE);
 
     expect(TokenType::RBRACE);
 
@@ -90,85 +156,112 @@ std::unique_ptr<Statement> Parser::parseIf() {
     return stmt;
 }
 
-std::unique_ptr<Expr> Parser::parseExpr() {
-    std::unique_ptr<Expr> left;
+Expr* Parser::parseExpr() {
+    Expr* left = nullptr;
 
     // literals
     if(current.type == TokenType::STRING) {
-        auto lit = std::make_unique<LiteralExpr>();
-        lit->value.type = ValueType::STRING;
-        lit->value.string = current.value;
-        left = std::move(lit);
+        auto lit = arena.make<LiteralExpr>();
+        lit->value = Value(std::string(current.value));
+        left = lit;
         advance();
     } 
     else if(current.type == TokenType::NUMBER) {
-        auto lit = std::make_unique<LiteralExpr>();
-        std::string s = current.value;
-        if (s.size() > 2 && s[0]=='0' && (s[1]=='x' || s[1]=='X')) {
-            lit->value.type = ValueType::NUMBER;
-            lit->value.number = std::stoll(s, nullptr, 16);
-        } else {
-            lit->value.type = ValueType::NUMBER;
-            lit->value.number = std::stod(s);
-        }
-        left = std::move(lit);
+        auto lit = arena.make<LiteralExpr>();
+        lit->value = Value(parseNumber(current.value));
+        left = lit;
         advance();
     } 
     else if(current.type == TokenType::TRUE || current.type == TokenType::FALSE) {
-        auto lit = std::make_unique<LiteralExpr>();
-        lit->value.type = ValueType::BOOLEAN;
-        lit->value.boolean = (current.type == TokenType::TRUE);
-        left = std::move(lit);
+        auto lit = arena.make<LiteralExpr>();
+        lit->value = Value(current.type == TokenType::TRUE);
+        left = lit;
         advance();
     } 
+    else if(current.type == TokenType::NOTHING) {
+        left = arena.make<LiteralExpr>();
+        advance();
+    }
+    else if(current.type == TokenType::CALL_TOKEN) {
+        left = parseCallExpr();
+    }
+    else if(current.type == TokenType::AWAIT) {
+        left = parseAwait();
+    }
+    else if(current.type == TokenType::LBRACKET) {
+        advance();
+        auto array = arena.make<ArrayExpr>();
+        array->elements = parseArgs(TokenType::RBRACKET);
+        expect(TokenType::RBRACKET);
+        left = array;
+    }
+    else if(current.type == TokenType::ARRAY) {
+        advance();
+        expect(TokenType::LPAREN);
+        auto array = arena.make<ArrayExpr>();
+        array->size = parseExpr();
+        expect(TokenType::RPAREN);
+        left = array;
+    }
+    else if(current.type == TokenType::LENGTH) {
+        advance();
+        expect(TokenType::LPAREN);
+        auto length = arena.make<LengthExpr>();
+        length->value = parseExpr();
+        expect(TokenType::RPAREN);
+        left = length;
+    }
     else if(current.type == TokenType::IDENT) {
-        auto var = std::make_unique<VariableExpr>();
-        var->name = current.value;
-        left = std::move(var);
+        auto var = arena.make<VariableExpr>();
+        var->name = keep(current.value);
+        left = var;
         advance();
 
+        if(current.type == TokenType::LBRACKET) {
+            advance();
+            auto element = arena.make<IndexExpr>();
+            element->array = left;
+            element->index = parseExpr();
+            expect(TokenType::RBRACKET);
+            left = element;
+        }
+
         if(current.type == TokenType::COLONCOLON) {
             advance();
 
             if(current.type != TokenType::IDENT && current.type != TokenType::IS)
                 throw std::runtime_error("Expected function name after ::");
-            std::string funcName = current.value;
+            std::string_view funcName = keep(current.value);
             advance();
 
             expect(TokenType::LPAREN);
 
-            auto callExpr = std::make_unique<CallExpr>();
-            callExpr->object = std::move(left);
+            auto callExpr = arena.make<CallExpr>();
+            callExpr->object = left;
             callExpr->function = funcName;
 
-            if(current.type != TokenType::RPAREN) {
-                callExpr->args.push_back(parseExpr());
-                while(current.type == TokenType::COMMA) {
-                    advance();
-                    callExpr->args.push_back(parseExpr());
-                }
-            }
+            callExpr->args = parseArgs();
 
             expect(TokenType::RPAREN);
-            left = std::move(callExpr);
+            left = callExpr;
         }
     }
     else if(current.type == TokenType::AMPERSAND) {
         advance();
         if(current.type != TokenType::IDENT)
             throw std::runtime_error("Expected identifier after &");
-        auto var = std::make_unique<VariableExpr>();
-        var->name = current.value;
-        left = std::move(var);
+        auto var = arena.make<VariableExpr>();
+        var->name = keep(current.value);
+        left = var;
         advance();
     }
     else if (current.type == TokenType::ASTERISK) {
         advance();
         if(current.type != TokenType::IDENT)
             throw std::runtime_error("Expected identifier after *");
-        auto var = std::make_unique<VariableExpr>();
-        var->name = current.value;
-        left = std::move(var);
+        auto var = arena.make<VariableExpr>();
+        var->name = keep(current.value);
+        left = var;
         advance();
     }
     else {
@@ -179,26 +272,41 @@ std::unique_ptr<Expr> Parser::parseExpr() {
     while(current.type == TokenType::PLUS) {
         advance();
         auto right = parseExpr();
-        auto bin = std::make_unique<BinaryExpr>();
-        bin->left = std::move(left);
-        bin->right = std::move(right);
+        auto bin = arena.make<BinaryExpr>();
+        bin->left = left;
+        bin->right = right;
         bin->op = '+';
-        left = std::move(bin);
+        left = bin;
     }
 
     return left;
 }
 
-std::unique_ptr<Statement> Parser::parseSet() {
+Statement* Parser::parseSet() {
     bool isconstant = false;
     if(current.type == TokenType::ALWAYS){ isconstant=true; advance(); }
 
     expect(TokenType::SET);
-    std::string name = current.value;
+    std::string_view name = keep(current.value);
     expect(TokenType::IDENT);
+
+    if(current.type == TokenType::LBRACKET) {
+        if(isconstant)
+            throw std::runtime_error("An array element cannot be ALWAYS SET");
+        advance();
+        auto stmt = arena.make<SetElementStatement>();
+        stmt->name = name;
+        stmt->index = parseExpr();
+        expect(TokenType::RBRACKET);
+        expect(TokenType::TO);
+        stmt->expr = parseExpr();
+        expect(TokenType::SEMICOLON);
+        return stmt;
+    }
+
     expect(TokenType::TO);
 
-    auto stmt = std::make_unique<SetStatement>();
+    auto stmt = arena.make<SetStatement>();
     stmt->name = name;
     stmt->isconstant = isconstant;
     stmt->expr = parseExpr();
@@ -207,67 +315,158 @@ std::unique_ptr<Statement> Parser::parseSet() {
     return stmt;
 }
 
-std::unique_ptr<Statement> Parser::parsePrint() {
+Statement* Parser::parsePrint() {
     expect(TokenType::PRINT);
 
-    auto stmt = std::make_unique<PrintStatement>();
+    auto stmt = arena.make<PrintStatement>();
     stmt->expr = parseExpr();
 
     expect(TokenType::SEMICOLON);
     return stmt;
 }
 
-std::unique_ptr<Statement> Parser::parseLoadDll() {
+Statement* Parser::parseLoadDll() {
     expect(TokenType::LOADDLL_TOKEN);
 
-    std::string dll = current.value;
+    std::string_view dll = keep(current.value);
     expect(TokenType::STRING);
 
     expect(TokenType::AS);
 
-    std::string alias = current.value;
+    std::string_view alias = keep(current.value);
     expect(TokenType::IDENT);
 
     expect(TokenType::SEMICOLON);
 
-    auto stmt = std::make_unique<LoadDllStatement>();
+    auto stmt = arena.make<LoadDllStatement>();
     stmt->dllName = dll;
     stmt->alias = alias;
     return stmt;
 }
 
-std::unique_ptr<Statement> Parser::parseCall() {
+Statement* Parser::parseCall() {
+    auto stmt = arena.make<CallDllStatement>();
+    stmt->call = parseCallExpr();
+
+    expect(TokenType::SEMICOLON);
+
+    return stmt;
+}
+
+CallDllExpr* Parser::parseCallExpr() {
     expect(TokenType::CALL_TOKEN);
 
-    std::string alias = current.value;
+    std::string_view alias = keep(current.value);
     expect(TokenType::IDENT);
 
     expect(TokenType::COLONCOLON);
 
-    std::string func = current.value;
+    std::string_view func = keep(current.value);
     expect(TokenType::IDENT);
 
     expect(TokenType::LPAREN);
 
-    auto stmt = std::make_unique<CallDllStatement>();
-    stmt->alias = alias;
-    stmt->function = func;
+    auto call = arena.make<CallDllExpr>();
+    call->alias = alias;
+    call->function = func;
+
+    call->args = parseArgs();
+
+    expect(TokenType::RPAREN);
+
+    return call;
+}
+
+Statement* Parser::parseAsyncCall() {
+    expect(TokenType::ASYNC);
+
+    auto stmt = arena.make<AsyncCallStatement>();
+    stmt->call = parseCallExpr();
+
+    expect(TokenType::AS);
+    stmt->name = keep(current.value);
+    expect(TokenType::IDENT);
+
+    expect(TokenType::SEMICOLON);
+    return stmt;
+}
+
+AwaitExpr* Parser::parseAwait() {
+    expect(TokenType::AWAIT);
+
+    auto expr = arena.make<AwaitExpr>();
+    if(current.type != TokenType::IDENT)
+        throw std::runtime_error("Expected a handle after AWAIT");
+    auto var = arena.make<VariableExpr>();
+    var->name = keep(current.value);
+    advance();
+    expr->handle = var;
+    return expr;
+}
+
+Statement* Parser::parseDeclare() {
+    expect(TokenType::DECLARE);
 
+    std::string_view alias = keep(current.value);
+    expect(TokenType::IDENT);
+
+    expect(TokenType::COLONCOLON);
+
+    std::string_view func = keep(current.value);
+    expect(TokenType::IDENT);
+
+    expect(TokenType::LPAREN);
+
+    size_t mark = pendingTypes.size();
     if(current.type != TokenType::RPAREN) {
-        stmt->args.push_back(parseExpr());
+        pendingTypes.push_back(parseFfiType());
         while(current.type == TokenType::COMMA) {
             advance();
-            stmt->args.push_back(parseExpr());
+            pendingTypes.push_back(parseFfiType());
         }
     }
 
     expect(TokenType::RPAREN);
+
+    auto stmt = arena.make<DeclareStatement>();
+    stmt->alias = alias;
+    stmt->function = func;
+    stmt->argTypes = arena.list(pendingTypes.data() + mark, pendingTypes.size() - mark);
+    pendingTypes.resize(mark);
+
+    if(current.type == TokenType::AS) {
+        advance();
+        stmt->returnType = parseFfiType();
+    }
+
     expect(TokenType::SEMICOLON);
 
     return stmt;
 }
 
-std::unique_ptr<Statement> Parser::parseLocalSet() {
+FfiType Parser::parseFfiType() {
+    static constexpr std::pair<std::string_view, FfiType> Types[] = {
+        {"VOID", FfiType::VOID},
+        {"BOOL", FfiType::BOOL},
+        {"INT", FfiType::INT},
+        {"INT64", FfiType::INT64},
+        {"DOUBLE", FfiType::DOUBLE},
+        {"PTR", FfiType::PTR},
+        {"STRING", FfiType::STRING},
+    };
+
+    if(current.type == TokenType::IDENT) {
+        for (const auto& [name, type] : Types) {
+            if (current.value == name) {
+                advance();
+                return type;
+            }
+        }
+    }
+    throw std::runtime_error("Unknown type in DECLARE");
+}
+
+Statement* Parser::parseLocalSet() {
     expect(TokenType::INSIDE);
 
     bool isconstant = false;
@@ -278,12 +477,12 @@ std::unique_ptr<Statement> Parser::parseLocalSet() {
 
     expect(TokenType::SET);
 
-    std::string name = current.value;
+    std::string_view name = keep(current.value);
     expect(TokenType::IDENT);
 
     expect(TokenType::TO);
 
-    auto stmt = std::make_unique<SetStatement>();
+    auto stmt = arena.make<SetStatement>();
     stmt->name = name;
     stmt->isconstant = isconstant;
     stmt->isLocal = true;
@@ -293,28 +492,28 @@ std::unique_ptr<Statement> Parser::parseLocalSet() {
     return stmt;
 }
 
-std::unique_ptr<Statement> Parser::parseSummon() {
+Statement* Parser::parseSummon() {
     expect(TokenType::SUMMON);
 
-    std::string filename = current.value;
+    std::string_view filename = keep(current.value);
     expect(TokenType::STRING);
 
-    std::string alias;
+    std::string_view alias;
     if (current.type == TokenType::AS) {
         advance();
-        alias = current.value;
+        alias = keep(current.value);
         expect(TokenType::IDENT);
     }
 
     expect(TokenType::SEMICOLON);
 
-    auto stmt = std::make_unique<SummonStatement>();
+    auto stmt = arena.make<SummonStatement>();
     stmt->filename = filename;
     stmt->alias = alias;
     return stmt;
 }
 
-std::unique_ptr<Statement> Parser::parseWhile() {
+Statement* Parser::parseWhile() {
     expect(TokenType::WHILE);
 
     auto condExpr = parseExpr();
@@ -324,11 +523,10 @@ std::unique_ptr<Statement> Parser::parseWhile() {
 
     expect(TokenType::LBRACE);
 
-    auto stmt = std::make_unique<WhileStatement>();
-    stmt->condition = std::move(condExpr);
+    auto stmt = arena.make<WhileStatement>();
+    stmt->condition = condExpr;
 
-    while(current.type != TokenType::RBRACE)
-        stmt->body.push_back(parseStatement());
+    stmt->body = parseBlockUntil(TokenType::RBRACE);
 
     expect(TokenType::RBRACE);
 
@@ -337,10 +535,10 @@ std::unique_ptr<Statement> Parser::parseWhile() {
     return stmt;
 }
 
-std::unique_ptr<Statement> Parser::parseFor() {
+Statement* Parser::parseFor() {
     expect(TokenType::FOR);
 
-    std::string varName = current.value;
+    std::string_view varName = keep(current.value);
     expect(TokenType::IDENT);
 
     expect(TokenType::EQUAL);
@@ -351,7 +549,7 @@ std::unique_ptr<Statement> Parser::parseFor() {
 
     auto end = parseExpr();
 
-    std::unique_ptr<Expr> step = nullptr;
+    Expr* step = nullptr;
     if(current.type == TokenType::STEP) {
         advance();
         step = parseExpr();
@@ -359,15 +557,51 @@ std::unique_ptr<Statement> Parser::parseFor() {
 
     expect(TokenType::LBRACE);
 
-    auto stmt = std::make_unique<ForStatement>();
+    auto stmt = arena.make<ForStatement>();
     stmt->varName = varName;
-    stmt->startExpr = std::move(start);
-    stmt->endExpr = std::move(end);
-    stmt->stepExpr = std::move(step);
+    stmt->startExpr = start;
+    stmt->endExpr = end;
+    stmt->stepExpr = step;
+
+    stmt->body = parseBlockUntil(TokenType::RBRACE);
+
+    expect(TokenType::RBRACE);
+
+    if(current.type == TokenType::SEMICOLON) advance();
+
+    return stmt;
+}
 
-    while(current.type != TokenType::RBRACE)
-        stmt->body.push_back(parseStatement());
+Statement* Parser::parseParallelFor() {
+    expect(TokenType::PARALLEL);
+    expect(TokenType::FOR);
+
+    auto stmt = arena.make<ParallelForStatement>();
+    stmt->varName = keep(current.value);
+    expect(TokenType::IDENT);
+
+    expect(TokenType::EQUAL);
+    stmt->startExpr = parseExpr();
+    expect(TokenType::TO);
+    stmt->endExpr = parseExpr();
+
+    if(current.type == TokenType::STEP) {
+        advance();
+        stmt->stepExpr = parseExpr();
+    }
 
+    if(current.type == TokenType::REDUCE) {
+        std::vector<std::string_view> names;
+        do {
+            advance();
+            names.push_back(keep(current.value));
+            expect(TokenType::IDENT);
+        } while(current.type == TokenType::COMMA);
+        stmt->reductions = arena.list(names.data(), names.size());
+    }
+
+    expect(TokenType::LBRACE);
+    stmt->body = parseBlockUntil(TokenType::RBRACE);
     expect(TokenType::RBRACE);
 
     if(current.type == TokenType::SEMICOLON) advance();
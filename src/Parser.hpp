@@ -1,5 +1,4 @@
 #pragma once
-#include <memory>
 #include <vector>
 
 #include "AST.hpp"
@@ -7,26 +6,50 @@
 
 class Parser {
 public:
-    explicit Parser(Lexer& lexer);
-    std::vector<std::unique_ptr<Statement>> parseProgram();
+    Parser(Lexer& lexer, Arena& arena);
+    StatementList parseProgram();
 
 private:
     Lexer& lexer;
+    Arena& arena;
     Token current;
 
+    // Line/column bookkeeping for statement positions. Statements start in
+    // source order, so newlines are only ever counted once.
+    size_t scanned = 0;
+    size_t lineStart = 0;
+    uint32_t line = 1;
+
+    // Children are collected here while a block or argument list is being
+    // parsed and then copied into the arena as one contiguous array.
+    std::vector<Statement*> pendingStatements;
+    std::vector<Expr*> pendingArgs;
+    std::vector<FfiType> pendingTypes;
+
     void advance();
+    void locate(size_t offset);
     void expect(TokenType type);
+    std::string_view keep(std::string_view text);
+    StatementList parseBlockUntil(TokenType end);
+    NodeList<Expr*> parseArgs(TokenType close = TokenType::RPAREN);
 
-    std::unique_ptr<Statement> parseStatement();
-    std::unique_ptr<Statement> parseSet();
-    std::unique_ptr<Statement> parsePrint();
-    std::unique_ptr<Expr> parseExpr();
-    std::unique_ptr<Statement> parseIf();
-    std::unique_ptr<Statement> parseLoadDll();
-    std::unique_ptr<Statement> parseCall();
-    std::unique_ptr<Statement> parseLocalSet();
-    std::unique_ptr<Statement> parseSummon();
-    std::unique_ptr<Statement> parseWhile();
-    std::unique_ptr<Statement> parseFor();
+    Statement* parseStatement();
+    Statement* parseStatementKind();
+    Statement* parseSet();
+    Statement* parsePrint();
+    Expr* parseExpr();
+    Statement* parseIf();
+    Statement* parseLoadDll();
+    Statement* parseCall();
+    CallDllExpr* parseCallExpr();
+    Statement* parseDeclare();
+    FfiType parseFfiType();
+    Statement* parseLocalSet();
+    Statement* parseSummon();
+    Statement* parseWhile();
+    Statement* parseFor();
+    Statement* parseParallelFor();
+    Statement* parseAsyncCall();
+    AwaitExpr* parseAwait();
 
 };
@@ -0,0 +1,138 @@
+#include "Profiler.hpp"
+#include "Interpreter.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <ostream>
+
+namespace {
+constexpr uint32_t Root = UINT32_MAX;
+const std::string UnknownFile = "?";
+
+} // namespace
+
+void Profiler::execute(Interpreter& in, const StatementList& body) {
+    for (Statement* stmt : body) {
+        enter(stmt);
+        stmt->execute(in);
+        exit();
+    }
+}
+
+void Profiler::enter(const Statement* stmt) {
+    uint32_t parent = stack.empty() ? Root : stack.back().node;
+
+    auto [it, inserted] = edges.try_emplace({parent, stmt}, static_cast<uint32_t>(nodes.size()));
+    if (inserted) {
+        Node node;
+        node.parent = parent;
+        node.file = files.empty() ? &UnknownFile : files.back();
+        node.line = stmt->line;
+        node.column = stmt->column;
+        node.kind = stmt->kind();
+        node.stmt = stmt;
+        nodes.push_back(node);
+    }
+
+    nodes[it->second].count++;
+    stack.push_back({it->second, Clock::now(), 0});
+}
+
+void Profiler::exit() {
+    Frame frame = stack.back();
+    stack.pop_back();
+
+    uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - frame.start).count();
+    Node& node = nodes[frame.node];
+    node.totalNs += elapsed;
+    node.selfNs += elapsed > frame.childNs ? elapsed - frame.childNs : 0;
+    if (!stack.empty())
+        stack.back().childNs += elapsed;
+}
+
+void Profiler::pushFile(std::string_view file) {
+    files.push_back(&*fileNames.emplace(file).first);
+}
+
+void Profiler::popFile() {
+    if (!files.empty()) files.pop_back();
+}
+
+// Closes the frames left open by a script that stopped with an error.
+void Profiler::finish() {
+    while (!stack.empty())
+        exit();
+}
+
+void Profiler::reset() {
+    nodes.clear();
+    edges.clear();
+    stack.clear();
+    files.clear();
+    fileNames.clear();
+}
+
+std::string Profiler::frameName(const Node& node) {
+    return *node.file + ":" + std::to_string(node.line) + " " + node.kind;
+}
+
+void Profiler::report(std::ostream& out, size_t top) {
+    finish();
+
+    // Merge the paths that lead to the same statement. A statement that is
+    // on the stack more than once (recursive SUMMON) has its total counted
+    // once per level.
+    struct Row {
+        const Node* node;
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+        uint64_t selfNs = 0;
+    };
+    std::unordered_map<const Statement*, Row> merged;
+    for (const Node& node : nodes) {
+        Row& row = merged.try_emplace(node.stmt, Row{&node}).first->second;
+        row.count += node.count;
+        row.totalNs += node.totalNs;
+        row.selfNs += node.selfNs;
+    }
+
+    std::vector<Row> rows;
+    for (auto& [stmt, row] : merged)
+        rows.push_back(row);
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.selfNs > b.selfNs; });
+    if (rows.size() > top) rows.resize(top);
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%12s %12s %12s %10s  %s\n", "self ms", "total ms", "count", "avg ns", "statement");
+    out << "\nProfile (hottest statements by self time)\n" << line;
+    for (const Row& row : rows) {
+        std::string where = *row.node->file + ":" + std::to_string(row.node->line) + ":" +
+                            std::to_string(row.node->column) + " " + row.node->kind;
+        std::snprintf(line, sizeof(line), "%12.3f %12.3f %12llu %10.0f  %s\n",
+                      row.selfNs / 1e6, row.totalNs / 1e6,
+                      static_cast<unsigned long long>(row.count),
+                      row.count ? double(row.totalNs) / row.count : 0.0, where.c_str());
+        out << line;
+    }
+}
+
+bool Profiler::writeFolded(const std::string& path) {
+    finish();
+
+    std::ofstream out(path);
+    if (!out) return false;
+
+    // One line per distinct stack: frames from the outermost statement in,
+    // weighted by self time in microseconds.
+    std::vector<std::string> names(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const Node& node = nodes[i];
+        std::string name = frameName(node);
+        names[i] = node.parent == Root ? name : names[node.parent] + ";" + name;
+
+        uint64_t micros = node.selfNs / 1000;
+        if (micros)
+            out << names[i] << ' ' << micros << '\n';
+    }
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "AST.hpp"
+
+class Interpreter;
+
+// Opt-in per-statement profiler (--profile), one per Interpreter. Every
+// executed statement is a frame on a stack that also spans SUMMONs, so each
+// distinct path from the entry script down to a statement gets its own count
+// and time. The report merges those paths per statement; the folded output
+// keeps them apart for flamegraph tools. When disabled, the engines only
+// test `enabled`.
+class Profiler {
+public:
+    bool enabled = false;
+
+    void enter(const Statement* stmt);
+    void exit();
+    // Runs the statements of a tree-walked block as frames of their own.
+    void execute(Interpreter& in, const StatementList& body);
+
+    // The script whose statements run next; SUMMON brackets the module.
+    void pushFile(std::string_view file);
+    void popFile();
+
+    void report(std::ostream& out, size_t top);
+    bool writeFolded(const std::string& path);
+    // Drops everything recorded so far.
+    void reset();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Node {
+        uint32_t parent;
+        const std::string* file;
+        uint32_t line;
+        uint32_t column;
+        const char* kind;
+        const Statement* stmt;
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+        uint64_t selfNs = 0;
+    };
+
+    struct Frame {
+        uint32_t node;
+        Clock::time_point start;
+        uint64_t childNs;
+    };
+
+    struct EdgeHash {
+        size_t operator()(const std::pair<uint32_t, const Statement*>& e) const {
+            return std::hash<const void*>{}(e.second) ^ (size_t(e.first) * 0x9E3779B97F4A7C15ull);
+        }
+    };
+
+    void finish();
+    static std::string frameName(const Node& node);
+
+    std::vector<Node> nodes;
+    std::unordered_map<std::pair<uint32_t, const Statement*>, uint32_t, EdgeHash> edges;
+    std::vector<Frame> stack;
+    std::vector<const std::string*> files;
+    std::unordered_set<std::string> fileNames;
+};
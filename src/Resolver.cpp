@@ -0,0 +1,150 @@
+#include "Resolver.hpp"
+
+void Resolver::resolve(Program& program) {
+    names.clear();
+    index.clear();
+    imports.clear();
+
+    resolveBlock(program.statements);
+    program.slotNames = std::move(names);
+    program.imports = std::move(imports);
+    names.clear();
+    imports.clear();
+}
+
+void Resolver::resolveBlock(const StatementList& body) {
+    for (Statement* stmt : body)
+        stmt->resolve(*this);
+}
+
+void Resolver::assigned(uint32_t slot) {
+    for (ForStatement* loop : loops)
+        if (loop->slot == slot) loop->counted = false;
+}
+
+// A SUMMONed module may SET any variable it can see.
+void Resolver::summoned() {
+    for (ForStatement* loop : loops)
+        loop->counted = false;
+}
+
+uint32_t Resolver::slot(std::string_view name) {
+    auto it = index.find(name);
+    if (it != index.end())
+        return it->second;
+
+    uint32_t s = static_cast<uint32_t>(names.size());
+    names.emplace_back(name);
+    index.emplace(std::string(name), s);
+    return s;
+}
+
+void VariableExpr::resolve(Resolver& r) {
+    slot = r.slot(name);
+}
+
+void BinaryExpr::resolve(Resolver& r) {
+    left->resolve(r);
+    right->resolve(r);
+}
+
+void ArrayExpr::resolve(Resolver& r) {
+    for (Expr* expr : elements)
+        expr->resolve(r);
+    if (size)
+        size->resolve(r);
+}
+
+void IndexExpr::resolve(Resolver& r) {
+    array->resolve(r);
+    index->resolve(r);
+}
+
+void LengthExpr::resolve(Resolver& r) {
+    value->resolve(r);
+}
+
+void SetStatement::resolve(Resolver& r) {
+    expr->resolve(r);
+    slot = r.slot(name);
+    r.assigned(slot);
+}
+
+void SetElementStatement::resolve(Resolver& r) {
+    index->resolve(r);
+    expr->resolve(r);
+    slot = r.slot(name);
+    r.assigned(slot);
+}
+
+void PrintStatement::resolve(Resolver& r) {
+    expr->resolve(r);
+}
+
+void IfStatement::resolve(Resolver& r) {
+    condition->resolve(r);
+    r.resolveBlock(body);
+}
+
+void CallDllExpr::resolve(Resolver& r) {
+    for (Expr* arg : args)
+        arg->resolve(r);
+}
+
+void CallDllStatement::resolve(Resolver& r) {
+    call->resolve(r);
+}
+
+void AsyncCallStatement::resolve(Resolver& r) {
+    call->resolve(r);
+    slot = r.slot(name);
+    r.assigned(slot);
+}
+
+void AwaitExpr::resolve(Resolver& r) {
+    handle->resolve(r);
+}
+
+void AwaitStatement::resolve(Resolver& r) {
+    await->resolve(r);
+}
+
+void SummonStatement::resolve(Resolver& r) {
+    r.import(filename);
+    r.summoned();
+}
+
+void WhileStatement::resolve(Resolver& r) {
+    condition->resolve(r);
+    r.resolveBlock(body);
+}
+
+void ForStatement::resolve(Resolver& r) {
+    startExpr->resolve(r);
+    endExpr->resolve(r);
+    if (stepExpr)
+        stepExpr->resolve(r);
+    slot = r.slot(varName);
+    r.assigned(slot);
+
+    counted = true;
+    r.enterLoop(this);
+    r.resolveBlock(body);
+    r.exitLoop();
+}
+
+void ParallelForStatement::resolve(Resolver& r) {
+    startExpr->resolve(r);
+    endExpr->resolve(r);
+    if (stepExpr)
+        stepExpr->resolve(r);
+    slot = r.slot(varName);
+    r.assigned(slot);
+    for (std::string_view name : reductions)
+        r.assigned(r.slot(name));
+
+    // The body runs on copies of the frames, so the counters of the
+    // enclosing loops have to be in them.
+    r.summoned();
+    r.resolveBlock(body);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AST.hpp"
+
+// Assigns every variable name used by a program a slot in that program's
+// own frame. Frames of enclosing programs (the callers of a SUMMON) are not
+// known until run time, so anything not found in the own frame falls back to
+// the name-based lookup in Runtime.
+class Resolver {
+public:
+    void resolve(Program& program);
+
+    void resolveBlock(const StatementList& body);
+    uint32_t slot(std::string_view name);
+    void import(std::string_view filename) { imports.push_back(filename); }
+
+    // Counted-loop bookkeeping for the FOR statements being resolved.
+    void enterLoop(ForStatement* loop) { loops.push_back(loop); }
+    void exitLoop() { loops.pop_back(); }
+    void assigned(uint32_t slot);
+    void summoned();
+
+private:
+    std::vector<ForStatement*> loops;
+    std::vector<std::string> names;
+    std::vector<std::string_view> imports;
+    NameMap<uint32_t> index;
+};
@@ -0,0 +1,75 @@
+#include "Rope.hpp"
+#include <vector>
+
+namespace {
+// Joining two short pieces is cheaper than keeping a node around for them.
+constexpr size_t EagerConcatLimit = 64;
+
+} // namespace
+
+Rope* Rope::leaf(std::string text) {
+    Rope* rope = new Rope();
+    rope->length = text.size();
+    rope->text = std::move(text);
+    return rope;
+}
+
+Rope* Rope::concat(Rope* left, Rope* right) {
+    if (left->length + right->length <= EagerConcatLimit) {
+        std::string joined;
+        joined.reserve(left->length + right->length);
+        joined += left->flat();
+        joined += right->flat();
+        left->release();
+        right->release();
+        return leaf(std::move(joined));
+    }
+
+    Rope* rope = new Rope();
+    rope->length = left->length + right->length;
+    rope->left = left;
+    rope->right = right;
+    return rope;
+}
+
+const std::string& Rope::flat() {
+    if (!left) return text;
+
+    std::string out;
+    out.reserve(length);
+
+    std::vector<Rope*> pending;
+    pending.push_back(this);
+    while (!pending.empty()) {
+        Rope* node = pending.back();
+        pending.pop_back();
+        if (node->left) {
+            pending.push_back(node->right);
+            pending.push_back(node->left);
+        } else {
+            out += node->text;
+        }
+    }
+
+    text = std::move(out);
+    left->release();
+    right->release();
+    left = right = nullptr;
+    return text;
+}
+
+void Rope::destroy(Rope* rope) {
+    // Ropes built in a loop are as deep as the loop was long, so children
+    // are released with an explicit stack rather than recursively.
+    std::vector<Rope*> dead;
+    dead.push_back(rope);
+    while (!dead.empty()) {
+        Rope* node = dead.back();
+        dead.pop_back();
+        for (Rope* child : {node->left, node->right}) {
+            if (child && --child->refs == 0)
+                dead.push_back(child);
+        }
+        delete node;
+    }
+}
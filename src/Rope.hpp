@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Immutable, reference-counted string. Concatenation builds a node that
+// points at both halves; the bytes are only laid out contiguously when
+// someone asks for flat(), and the result is cached in the node.
+class Rope {
+public:
+    static Rope* leaf(std::string text);
+    // Takes ownership of one reference to each side.
+    static Rope* concat(Rope* left, Rope* right);
+
+    void retain() { refs++; }
+    void release() {
+        if (--refs == 0) destroy(this);
+    }
+
+    size_t size() const { return length; }
+    const std::string& flat();
+
+private:
+    Rope() = default;
+
+    static void destroy(Rope* rope);
+
+    uint32_t refs = 1;
+    size_t length = 0;
+    std::string text;
+    Rope* left = nullptr;
+    Rope* right = nullptr;
+};
@@ -0,0 +1,183 @@
+#include "Runtime.hpp"
+#include "Lexer.hpp"
+#include "Parser.hpp"
+#include "Resolver.hpp"
+#include "Optimizer.hpp"
+#include "SourceFile.hpp"
+#include "ScriptCache.hpp"
+#include "Output.hpp"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+std::string arrayText(const NumArray& array) {
+    std::string text = "[";
+    char number[NumberBufferSize];
+    for (size_t i = 0; i < array.size(); i++) {
+        if (i) text += ", ";
+        text.append(number, formatNumber(number, array.data()[i]));
+    }
+    text += ']';
+    return text;
+}
+
+namespace {
+Rope* toRope(const Value& v) {
+    if (v.type == ValueType::STRING) {
+        v.string->retain();
+        return v.string;
+    }
+    if (v.type == ValueType::NUMBER) {
+        char text[NumberBufferSize];
+        return Rope::leaf(std::string(text, formatFixed(text, v.number)));
+    }
+    if (v.type == ValueType::ARRAY)
+        return Rope::leaf(arrayText(*v.array));
+    return Rope::leaf(v.isTrue() ? "TRUE!" : "FALSE!");
+}
+
+std::string lengths(const NumArray& l, const NumArray& r) {
+    return std::to_string(l.size()) + " and " + std::to_string(r.size());
+}
+
+// Element-wise `+` of two arrays of one length, or of an array and a number.
+Value addArrays(const Value& l, const Value& r) {
+    if (l.type == ValueType::ARRAY && r.type == ValueType::ARRAY) {
+        if (l.array->size() != r.array->size())
+            throw std::runtime_error("Cannot add arrays of lengths " + lengths(*l.array, *r.array));
+        NumArray* sum = NumArray::uninitialized(l.array->size());
+        numkernels::add(sum->data(), l.array->data(), r.array->data(), sum->size());
+        return Value(sum);
+    }
+
+    const Value& array = l.type == ValueType::ARRAY ? l : r;
+    const Value& number = l.type == ValueType::ARRAY ? r : l;
+    if (number.type != ValueType::NUMBER)
+        throw std::runtime_error("Invalid types for +");
+    NumArray* sum = NumArray::uninitialized(array.array->size());
+    numkernels::addScalar(sum->data(), array.array->data(), number.number, sum->size());
+    return Value(sum);
+}
+
+// `=` holds when every element is equal to the other array's (of the same
+// length) or to the number.
+bool equalArrays(const Value& l, const Value& r) {
+    if (l.type == ValueType::ARRAY && r.type == ValueType::ARRAY)
+        return l.array->size() == r.array->size() &&
+               numkernels::equal(l.array->data(), r.array->data(), l.array->size());
+
+    const Value& array = l.type == ValueType::ARRAY ? l : r;
+    const Value& number = l.type == ValueType::ARRAY ? r : l;
+    return number.type == ValueType::NUMBER &&
+           numkernels::equalScalar(array.array->data(), number.number, array.array->size());
+}
+
+} // namespace
+
+Value concatValues(const Value& l, const Value& r) {
+    return Value(Rope::concat(toRope(l), toRope(r)));
+}
+
+Value addValues(const Value& l, const Value& r) {
+    if(l.type == ValueType::STRING || r.type == ValueType::STRING) {
+        return concatValues(l, r);
+    }
+    if(l.type==ValueType::NUMBER && r.type==ValueType::NUMBER) {
+        return Value(l.number + r.number);
+    }
+    if(l.type == ValueType::ARRAY || r.type == ValueType::ARRAY) {
+        return addArrays(l, r);
+    }
+    throw std::runtime_error("Invalid types for +");
+}
+
+Value equalValues(const Value& l, const Value& r) {
+    if(l.type == ValueType::ARRAY || r.type == ValueType::ARRAY)
+        return Value(equalArrays(l, r));
+    if(l.type != r.type)
+        return Value(false);
+    if(l.type==ValueType::NUMBER)
+        return Value(l.number == r.number);
+    if(l.type==ValueType::STRING)
+        return Value(l.str() == r.str());
+    if(l.type==ValueType::BOOLEAN)
+        return Value(l.boolean == r.boolean);
+    return Value(false);
+}
+
+Value arrayOf(const Value* elements, size_t count) {
+    Value result(NumArray::uninitialized(count));
+    double* out = result.array->data();
+    for (size_t i = 0; i < count; i++) {
+        if (elements[i].type != ValueType::NUMBER)
+            throw std::runtime_error("Array elements must be numbers");
+        out[i] = elements[i].number;
+    }
+    return result;
+}
+
+Value zeros(const Value& count) {
+    if (count.type != ValueType::NUMBER || !(count.number >= 0) || count.number != std::floor(count.number) ||
+        count.number > static_cast<double>(std::numeric_limits<uint32_t>::max()))
+        throw std::runtime_error("ARRAY size must be a whole number from 0");
+    return Value(NumArray::make(static_cast<size_t>(count.number)));
+}
+
+size_t elementOffset(const NumArray& array, const Value& index) {
+    if (index.type != ValueType::NUMBER)
+        throw std::runtime_error("Array index must be a number");
+    double i = index.number;
+    if (!(i >= 1 && i <= static_cast<double>(array.size()) && i == std::floor(i))) {
+        char text[NumberBufferSize];
+        throw std::runtime_error("Array index out of range: " + std::string(text, formatNumber(text, i)) +
+                                 " (length " + std::to_string(array.size()) + ")");
+    }
+    return static_cast<size_t>(i) - 1;
+}
+
+Value elementOf(const Value& array, const Value& index) {
+    if (array.type != ValueType::ARRAY)
+        throw std::runtime_error("Only arrays can be indexed");
+    return Value(array.array->data()[elementOffset(*array.array, index)]);
+}
+
+Value lengthOf(const Value& value) {
+    if (value.type == ValueType::ARRAY)
+        return Value(static_cast<double>(value.array->size()));
+    if (value.type == ValueType::STRING)
+        return Value(static_cast<double>(value.string->size()));
+    throw std::runtime_error("LENGTH needs an array or a string");
+}
+
+Program parseSource(std::string_view src) {
+    Program program;
+
+    Lexer lexer(src);
+    Parser parser(lexer, program.arena);
+    program.statements = parser.parseProgram();
+    if (Optimizer::enabled)
+        Optimizer(program.arena).optimize(program);
+    Resolver().resolve(program);
+    return program;
+}
+
+Program parseScript(const std::string& filename, std::string_view src) {
+    if (!ScriptCache::enabled)
+        return parseSource(src);
+
+    std::optional<CacheKey> key = ScriptCache::keyFor(filename, src);
+    if (!key)
+        return parseSource(src);
+    if (std::optional<Program> cached = ScriptCache::load(*key))
+        return std::move(*cached);
+
+    Program program = parseSource(src);
+    ScriptCache::store(*key, program);
+    return program;
+}
+
+Program parseFile(const std::string& filename) {
+    SourceFile source(filename);
+    return parseScript(filename, source.text());
+}
@@ -1,25 +1,25 @@
 #pragma once
-#include <unordered_map>
 #include <string>
-#include <vector>
+#include <string_view>
 #include "AST.hpp"
-#define WIN32_LEAN_AND_MEAN
-#define NOMINMAX
-#include <windows.h>
 
-using Scope = std::unordered_map<std::string, Variable>;
+// Shared by the tree-walking interpreter and the bytecode VM so both
+// engines agree on the language semantics.
+Value addValues(const Value& l, const Value& r);
+// `+` when at least one side is a string.
+Value concatValues(const Value& l, const Value& r);
+Value equalValues(const Value& l, const Value& r);
+// `[a, b, ...]`, `ARRAY(n)`, `A[I]` and `LENGTH(A)`. Indexes start at 1.
+Value arrayOf(const Value* elements, size_t count);
+Value zeros(const Value& count);
+Value elementOf(const Value& array, const Value& index);
+Value lengthOf(const Value& value);
+// Where element `index` of `array` is, once it is checked to be a whole
+// number from 1 to the length.
+size_t elementOffset(const NumArray& array, const Value& index);
+// How PRINT and `+` with a string spell an array: `[1, 2.5, 3]`.
+std::string arrayText(const NumArray& array);
 
-inline std::vector<Scope> ScopeStack;
-inline std::unordered_map<std::string, Scope> FileScopes;
-inline std::unordered_map<std::string, HMODULE> LoadedDLLs;
-
-inline void pushScope() { ScopeStack.emplace_back(); }
-inline void popScope() { ScopeStack.pop_back(); }
-
-inline Variable* findVariable(const std::string& name) {
-    for(auto it = ScopeStack.rbegin(); it != ScopeStack.rend(); ++it){
-        auto v = it->find(name);
-        if(v != it->end()) return &v->second;
-    }
-    return nullptr;
-}
+Program parseSource(std::string_view src);
+Program parseScript(const std::string& filename, std::string_view src);
+Program parseFile(const std::string& filename);
@@ -0,0 +1,643 @@
+#include "ScriptCache.hpp"
+#include "SourceFile.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+// Bump whenever the node layout or anything the Resolver stores changes.
+constexpr uint32_t FormatVersion = 9;
+constexpr char Magic[4] = {'J', 'G', 'S', 'C'};
+
+uint64_t fnv1a(std::string_view data) {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Reads back what CacheWriter produced, allocating the nodes into the
+// arena of the Program being restored. Any inconsistency (a missing
+// child, a slot past the frame, an unknown tag) throws and the entry is
+// treated as a miss.
+class CacheReader {
+public:
+    CacheReader(std::string_view data, Arena& arena)
+        : p(data.data()), end(data.data() + data.size()), arena(arena) {}
+
+    const char* bytes(size_t n) {
+        if (static_cast<size_t>(end - p) < n)
+            throw std::runtime_error("Truncated cache entry");
+        const char* at = p;
+        p += n;
+        return at;
+    }
+
+    template <typename T>
+    T read() {
+        T v;
+        std::memcpy(&v, bytes(sizeof(T)), sizeof(T));
+        return v;
+    }
+
+    uint8_t u8() { return read<uint8_t>(); }
+    uint32_t u32() { return read<uint32_t>(); }
+    uint64_t u64() { return read<uint64_t>(); }
+    double f64() { return read<double>(); }
+
+    std::string_view raw() {
+        uint32_t n = u32();
+        return {bytes(n), n};
+    }
+    std::string_view str() { return arena.copy(raw()); }
+
+    Value value() {
+        switch (static_cast<ValueType>(u8())) {
+            case ValueType::NUMBER:  return Value(f64());
+            case ValueType::BOOLEAN: return Value(u8() != 0);
+            case ValueType::STRING:  return Value(std::string(raw()));
+            case ValueType::NOTHING: return Value();
+            default: throw std::runtime_error("Bad value in cache entry");
+        }
+    }
+
+    FfiType ffiType() {
+        uint8_t t = u8();
+        if (t > static_cast<uint8_t>(FfiType::STRING))
+            throw std::runtime_error("Bad type in cache entry");
+        return static_cast<FfiType>(t);
+    }
+
+    Expr* expr();
+    Statement* statement();
+
+    // A child the node cannot do without.
+    Expr* required() {
+        Expr* e = expr();
+        if (!e)
+            throw std::runtime_error("Bad expression in cache entry");
+        return e;
+    }
+
+    uint32_t slot() {
+        uint32_t s = u32();
+        if (s >= slots)
+            throw std::runtime_error("Bad slot in cache entry");
+        return s;
+    }
+
+    CallDllExpr* callDll() {
+        auto e = arena.make<CallDllExpr>();
+        e->alias = str();
+        e->function = str();
+        e->args = exprs();
+        return e;
+    }
+
+    AwaitExpr* await() {
+        auto e = arena.make<AwaitExpr>();
+        e->handle = required();
+        return e;
+    }
+
+    // Every node takes at least one byte, which bounds a sane list length.
+    uint32_t count() {
+        uint32_t n = u32();
+        if (n > static_cast<size_t>(end - p))
+            throw std::runtime_error("Truncated cache entry");
+        return n;
+    }
+
+    NodeList<Expr*> exprs() {
+        std::vector<Expr*> items(count());
+        for (Expr*& e : items)
+            e = required();
+        return arena.list(items.data(), items.size());
+    }
+
+    StatementList block() {
+        std::vector<Statement*> items(count());
+        for (Statement*& s : items) {
+            s = statement();
+            s->line = u32();
+            s->column = u32();
+        }
+        return arena.list(items.data(), items.size());
+    }
+
+    bool done() const { return p == end; }
+
+    // Frame size of the program being read; slots at or past it are
+    // rejected.
+    size_t slots = std::numeric_limits<size_t>::max();
+
+private:
+    const char* p;
+    const char* end;
+    Arena& arena;
+};
+
+Expr* CacheReader::expr() {
+    switch (static_cast<NodeTag>(u8())) {
+        case NodeTag::NONE:
+            return nullptr;
+        case NodeTag::LITERAL: {
+            auto e = arena.make<LiteralExpr>();
+            e->value = value();
+            return e;
+        }
+        case NodeTag::VARIABLE: {
+            auto e = arena.make<VariableExpr>();
+            e->name = str();
+            e->slot = slot();
+            return e;
+        }
+        case NodeTag::BINARY: {
+            auto e = arena.make<BinaryExpr>();
+            e->op = static_cast<char>(u8());
+            if (e->op != '+' && e->op != '=')
+                throw std::runtime_error("Bad expression in cache entry");
+            e->left = required();
+            e->right = required();
+            return e;
+        }
+        case NodeTag::CALL: {
+            auto e = arena.make<CallExpr>();
+            e->object = required();
+            e->function = str();
+            e->args = exprs();
+            return e;
+        }
+        case NodeTag::ARRAY: {
+            auto e = arena.make<ArrayExpr>();
+            e->elements = exprs();
+            e->size = expr();
+            return e;
+        }
+        case NodeTag::INDEX: {
+            auto e = arena.make<IndexExpr>();
+            e->array = required();
+            e->index = required();
+            return e;
+        }
+        case NodeTag::LENGTH: {
+            auto e = arena.make<LengthExpr>();
+            e->value = required();
+            return e;
+        }
+        case NodeTag::CALL_DLL_EXPR:
+            return callDll();
+        case NodeTag::AWAIT:
+            return await();
+        default:
+            throw std::runtime_error("Bad expression in cache entry");
+    }
+}
+
+Statement* CacheReader::statement() {
+    switch (static_cast<NodeTag>(u8())) {
+        case NodeTag::SET: {
+            auto s = arena.make<SetStatement>();
+            s->name = str();
+            s->slot = slot();
+            uint8_t flags = u8();
+            s->isconstant = flags & 1;
+            s->isLocal = flags & 2;
+            s->expr = required();
+            return s;
+        }
+        case NodeTag::SET_ELEMENT: {
+            auto s = arena.make<SetElementStatement>();
+            s->name = str();
+            s->slot = slot();
+            s->index = required();
+            s->expr = required();
+            return s;
+        }
+        case NodeTag::PRINT: {
+            auto s = arena.make<PrintStatement>();
+            s->expr = required();
+            return s;
+        }
+        case NodeTag::IF: {
+            auto s = arena.make<IfStatement>();
+            s->condition = required();
+            s->body = block();
+            return s;
+        }
+        case NodeTag::LOAD_DLL: {
+            auto s = arena.make<LoadDllStatement>();
+            s->dllName = str();
+            s->alias = str();
+            return s;
+        }
+        case NodeTag::CALL_DLL: {
+            auto s = arena.make<CallDllStatement>();
+            if (static_cast<NodeTag>(u8()) != NodeTag::CALL_DLL_EXPR)
+                throw std::runtime_error("Bad statement in cache entry");
+            s->call = callDll();
+            return s;
+        }
+        case NodeTag::DECLARE: {
+            auto s = arena.make<DeclareStatement>();
+            s->alias = str();
+            s->function = str();
+            s->returnType = ffiType();
+            std::vector<FfiType> types(count());
+            for (FfiType& t : types)
+                t = ffiType();
+            s->argTypes = arena.list(types.data(), types.size());
+            return s;
+        }
+        case NodeTag::SUMMON: {
+            auto s = arena.make<SummonStatement>();
+            s->filename = str();
+            s->alias = str();
+            return s;
+        }
+        case NodeTag::WHILE: {
+            auto s = arena.make<WhileStatement>();
+            s->condition = required();
+            s->body = block();
+            return s;
+        }
+        case NodeTag::FOR: {
+            auto s = arena.make<ForStatement>();
+            s->varName = str();
+            s->slot = slot();
+            s->counted = u8() != 0;
+            s->startExpr = required();
+            s->endExpr = required();
+            s->stepExpr = expr();
+            s->body = block();
+            return s;
+        }
+        case NodeTag::ASYNC_CALL: {
+            auto s = arena.make<AsyncCallStatement>();
+            if (static_cast<NodeTag>(u8()) != NodeTag::CALL_DLL_EXPR)
+                throw std::runtime_error("Bad statement in cache entry");
+            s->call = callDll();
+            s->name = str();
+            s->slot = slot();
+            return s;
+        }
+        case NodeTag::AWAIT_STATEMENT: {
+            auto s = arena.make<AwaitStatement>();
+            if (static_cast<NodeTag>(u8()) != NodeTag::AWAIT)
+                throw std::runtime_error("Bad statement in cache entry");
+            s->await = await();
+            return s;
+        }
+        case NodeTag::PARALLEL_FOR: {
+            auto s = arena.make<ParallelForStatement>();
+            s->varName = str();
+            s->slot = slot();
+            s->startExpr = required();
+            s->endExpr = required();
+            s->stepExpr = expr();
+            std::vector<std::string_view> names(count());
+            for (std::string_view& name : names)
+                name = str();
+            s->reductions = arena.list(names.data(), names.size());
+            s->body = block();
+            return s;
+        }
+        default:
+            throw std::runtime_error("Bad statement in cache entry");
+    }
+}
+
+void writeHeader(CacheWriter& w, const CacheKey& key) {
+    w.out.append(Magic, sizeof(Magic));
+    w.u32(FormatVersion);
+    w.str(key.path);
+    w.u64(key.size);
+    w.u64(static_cast<uint64_t>(key.mtime));
+    w.u64(key.hash);
+}
+
+} // namespace
+
+void CacheWriter::u32(uint32_t v) {
+    out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+void CacheWriter::u64(uint64_t v) {
+    out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+void CacheWriter::f64(double v) {
+    out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+void CacheWriter::str(std::string_view s) {
+    u32(static_cast<uint32_t>(s.size()));
+    out.append(s.data(), s.size());
+}
+
+void CacheWriter::value(const Value& v) {
+    u8(static_cast<uint8_t>(v.type));
+    switch (v.type) {
+        case ValueType::NUMBER:  f64(v.number); break;
+        case ValueType::BOOLEAN: u8(v.boolean); break;
+        case ValueType::STRING:  str(v.str()); break;
+        case ValueType::NOTHING: break;
+        default: throw std::runtime_error("Cannot cache value");
+    }
+}
+
+void CacheWriter::expr(Expr* e) {
+    if (e)
+        e->serialize(*this);
+    else
+        tag(NodeTag::NONE);
+}
+
+void CacheWriter::block(const StatementList& body) {
+    u32(static_cast<uint32_t>(body.size()));
+    for (Statement* stmt : body) {
+        stmt->serialize(*this);
+        u32(stmt->line);
+        u32(stmt->column);
+    }
+}
+
+void CacheWriter::exprs(const NodeList<Expr*>& list) {
+    u32(static_cast<uint32_t>(list.size()));
+    for (Expr* e : list)
+        expr(e);
+}
+
+std::optional<CacheKey> ScriptCache::keyFor(const std::string& filename, std::string_view text) {
+    std::error_code ec;
+    fs::path path = fs::weakly_canonical(filename, ec);
+    if (ec) return std::nullopt;
+    auto mtime = fs::last_write_time(path, ec);
+    if (ec) return std::nullopt;
+
+    CacheKey key;
+    key.path = path.string();
+    key.size = text.size();
+    key.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    key.hash = fnv1a(text);
+    return key;
+}
+
+std::string ScriptCache::entryPath(const CacheKey& key) {
+    if (directory.empty())
+        return key.path + ".jgsc";
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.jgsc", static_cast<unsigned long long>(fnv1a(key.path)));
+    return (fs::path(directory) / name).string();
+}
+
+std::optional<Program> ScriptCache::load(const CacheKey& key) {
+    std::string entry = entryPath(key);
+    std::error_code ec;
+    if (!fs::exists(entry, ec)) return std::nullopt;
+
+    try {
+        SourceFile file(entry);
+
+        CacheWriter expected;
+        writeHeader(expected, key);
+        std::string_view data = file.text();
+        if (data.size() < expected.out.size() + sizeof(uint64_t) ||
+            data.substr(0, expected.out.size()) != expected.out)
+            return std::nullopt;
+
+        // The header only says which script the entry was built from; the
+        // checksum catches an entry that was cut short or damaged since.
+        uint64_t checksum;
+        std::memcpy(&checksum, data.data() + expected.out.size(), sizeof(checksum));
+        std::string_view body = data.substr(expected.out.size() + sizeof(checksum));
+        if (fnv1a(body) != checksum)
+            return std::nullopt;
+
+        Program program;
+        CacheReader reader(body, program.arena);
+        uint32_t slots = reader.count();
+        program.slotNames.reserve(slots);
+        for (uint32_t i = 0; i < slots; i++)
+            program.slotNames.emplace_back(reader.raw());
+        reader.slots = slots;
+        uint32_t imports = reader.count();
+        for (uint32_t i = 0; i < imports; i++)
+            program.imports.push_back(reader.str());
+        program.statements = reader.block();
+        if (!reader.done())
+            return std::nullopt;
+        return program;
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+void ScriptCache::store(const CacheKey& key, const Program& program) {
+    CacheWriter w;
+    try {
+        CacheWriter body;
+        body.u32(static_cast<uint32_t>(program.slotNames.size()));
+        for (const std::string& name : program.slotNames)
+            body.str(name);
+        body.u32(static_cast<uint32_t>(program.imports.size()));
+        for (std::string_view filename : program.imports)
+            body.str(filename);
+        body.block(program.statements);
+
+        writeHeader(w, key);
+        w.u64(fnv1a(body.out));
+        w.out += body.out;
+    } catch (const std::exception&) {
+        return;
+    }
+
+    // Written under a temporary name and renamed into place so concurrent
+    // runs never see a partial entry. A cache that cannot be written (for
+    // example a read-only script directory) is simply skipped.
+    std::string entry = entryPath(key);
+    std::string temp = entry + "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "." +
+                       std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary);
+        if (!out) return;
+        out.write(w.out.data(), static_cast<std::streamsize>(w.out.size()));
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            fs::remove(temp, ec);
+            return;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(temp, entry, ec);
+    if (ec) fs::remove(temp, ec);
+}
+
+StatementList ScriptCache::copy(const StatementList& body, Arena& arena) {
+    CacheWriter w;
+    w.block(body);
+    CacheReader reader(w.out, arena);
+    return reader.block();
+}
+
+void LiteralExpr::serialize(CacheWriter& w) {
+    w.tag(NodeTag::LITERAL);
+    w.value(value);
+}
+
+void VariableExpr::serialize(CacheWriter& w) {
+    w.tag(NodeTag::VARIABLE);
+    w.str(name);
+    w.u32(slot);
+}
+
+void BinaryExpr::serialize(CacheWriter& w) {
+    w.tag(NodeTag::BINARY);
+    w.u8(static_cast<uint8_t>(op));
+    w.expr(left);
+    w.expr(right);
+}
+
+void ArrayExpr::serialize(CacheWriter& w) {
+    w.tag(NodeTag::ARRAY);
+    w.exprs(elements);
+    w.expr(size);
+}
+
+void IndexExpr::serialize(CacheWriter& w) {
+    w.tag(NodeTag::INDEX);
+    w.expr(array);
+    w.expr(index);
+}
+
+void LengthExpr::serialize(CacheWriter& w) {
+    w.tag(NodeTag::LENGTH);
+    w.expr(value);
+}
+
+void CallExpr::serialize(CacheWriter& w) {
+    w.tag(NodeTag::CALL);
+    w.expr(object);
+    w.str(function);
+    w.exprs(args);
+}
+
+void SetStatement::serialize(CacheWriter& w) {
+    w.tag(NodeTag::SET);
+    w.str(name);
+    w.u32(slot);
+    w.u8((isconstant ? 1 : 0) | (isLocal ? 2 : 0));
+    w.expr(expr);
+}
+
+void SetElementStatement::serialize(CacheWriter& w) {
+    w.tag(NodeTag::SET_ELEMENT);
+    w.str(name);
+    w.u32(slot);
+    w.expr(index);
+    w.expr(expr);
+}
+
+void PrintStatement::serialize(CacheWriter& w) {
+    w.tag(NodeTag::PRINT);
+    w.expr(expr);
+}
+
+void IfStatement::serialize(CacheWriter& w) {
+    w.tag(NodeTag::IF);
+    w.expr(condition);
+    w.block(body);
+}
+
+void LoadDllStatement::serialize(CacheWriter& w) {
+    w.tag(NodeTag::LOAD_DLL);
+    w.str(dllName);
+    w.str(alias);
+}
+
+void CallDllExpr::serialize(CacheWriter& w) {
+    w.tag(NodeTag::CALL_DLL_EXPR);
+    w.str(alias);
+    w.str(function);
+    w.exprs(args);
+}
+
+void CallDllStatement::serialize(CacheWriter& w) {
+    w.tag(NodeTag::CALL_DLL);
+    call->serialize(w);
+}
+
+void DeclareStatement::serialize(CacheWriter& w) {
+    w.tag(NodeTag::DECLARE);
+    w.str(alias);
+    w.str(function);
+    w.u8(static_cast<uint8_t>(returnType));
+    w.u32(static_cast<uint32_t>(argTypes.size()));
+    for (FfiType t : argTypes)
+        w.u8(static_cast<uint8_t>(t));
+}
+
+void SummonStatement::serialize(CacheWriter& w) {
+    w.tag(NodeTag::SUMMON);
+    w.str(filename);
+    w.str(alias);
+}
+
+void WhileStatement::serialize(CacheWriter& w) {
+    w.tag(NodeTag::WHILE);
+    w.expr(condition);
+    w.block(body);
+}
+
+void ForStatement::serialize(CacheWriter& w) {
+    w.tag(NodeTag::FOR);
+    w.str(varName);
+    w.u32(slot);
+    w.u8(counted);
+    w.expr(startExpr);
+    w.expr(endExpr);
+    w.expr(stepExpr);
+    w.block(body);
+}
+
+void ParallelForStatement::serialize(CacheWriter& w) {
+    w.tag(NodeTag::PARALLEL_FOR);
+    w.str(varName);
+    w.u32(slot);
+    w.expr(startExpr);
+    w.expr(endExpr);
+    w.expr(stepExpr);
+    w.u32(static_cast<uint32_t>(reductions.size()));
+    for (std::string_view name : reductions)
+        w.str(name);
+    w.block(body);
+}
+
+void AsyncCallStatement::serialize(CacheWriter& w) {
+    w.tag(NodeTag::ASYNC_CALL);
+    call->serialize(w);
+    w.str(name);
+    w.u32(slot);
+}
+
+void AwaitExpr::serialize(CacheWriter& w) {
+    w.tag(NodeTag::AWAIT);
+    w.expr(handle);
+}
+
+void AwaitStatement::serialize(CacheWriter& w) {
+    w.tag(NodeTag::AWAIT_STATEMENT);
+    await->serialize(w);
+}
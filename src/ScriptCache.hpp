@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "AST.hpp"
+
+enum class NodeTag : uint8_t {
+    NONE,
+    LITERAL,
+    VARIABLE,
+    BINARY,
+    CALL,
+    CALL_DLL_EXPR,
+    SET,
+    PRINT,
+    IF,
+    LOAD_DLL,
+    CALL_DLL,
+    SUMMON,
+    WHILE,
+    FOR,
+    DECLARE,
+    PARALLEL_FOR,
+    ASYNC_CALL,
+    AWAIT,
+    AWAIT_STATEMENT,
+    ARRAY,
+    INDEX,
+    LENGTH,
+    SET_ELEMENT,
+};
+
+// Flattens a resolved Program into the byte layout of a .jgsc file. Every
+// node writes its tag followed by its fields; child lists are a count
+// followed by the children.
+class CacheWriter {
+public:
+    void tag(NodeTag t) { u8(static_cast<uint8_t>(t)); }
+    void u8(uint8_t v) { out.push_back(static_cast<char>(v)); }
+    void u32(uint32_t v);
+    void u64(uint64_t v);
+    void f64(double v);
+    void str(std::string_view s);
+    void value(const Value& v);
+    void expr(Expr* e);
+    void block(const StatementList& body);
+    void exprs(const NodeList<Expr*>& list);
+
+    std::string out;
+};
+
+// What a cached program was built from. An entry is only used when all
+// four fields match the script on disk.
+struct CacheKey {
+    std::string path;
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    uint64_t hash = 0;
+};
+
+// Persists parsed and resolved programs as .jgsc files so that scripts that
+// have not changed since the last run skip the Lexer and Parser. By default
+// the file sits next to the script, named after all of it (`lib.jorge` ->
+// `lib.jorge.jgsc`, so `lib.jgs` beside it keeps an entry of its own); with
+// a cache directory set, entries are named after a hash of the script's
+// path.
+class ScriptCache {
+public:
+    static inline bool enabled = true;
+    static inline std::string directory;
+
+    static std::optional<CacheKey> keyFor(const std::string& filename, std::string_view text);
+    static std::optional<Program> load(const CacheKey& key);
+    static void store(const CacheKey& key, const Program& program);
+
+    // A deep copy of `body` in `arena`, made by writing it out and reading
+    // it back. The copy shares no call sites, quickened nodes or strings
+    // with the original, so another thread can run it.
+    static StatementList copy(const StatementList& body, Arena& arena);
+
+private:
+    static std::string entryPath(const CacheKey& key);
+};
@@ -0,0 +1,444 @@
+#include "Server.hpp"
+
+#ifdef _WIN32
+
+bool Server::available() { return false; }
+
+int Server::serve(const std::string&, const Handler&) { return 1; }
+
+int Server::request(const std::string&, const std::string&, const std::vector<std::string>&, const std::string*) {
+    return -1;
+}
+
+bool Server::stop(const std::string&) { return false; }
+
+#else
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+enum class Command : char {
+    RUN = 'R',
+    STOP = 'S',
+};
+
+#ifdef MSG_NOSIGNAL
+constexpr int SendFlags = MSG_NOSIGNAL;
+#else
+constexpr int SendFlags = 0;
+#endif
+
+// Requests larger than this are refused rather than allocated.
+constexpr uint32_t MaxRequest = 1u << 30;
+// A client writes its whole request as soon as it connects. One that stays
+// quiet longer than this is dropped so it cannot hold up the ones behind it.
+constexpr int RequestTimeoutSeconds = 2;
+
+// A RUN request after its command byte: the body length, then the working
+// directory, the argument count and arguments, and whether source text
+// follows. Both ends run on the same machine, so integers go in host order.
+struct RequestWriter {
+    void u32(uint32_t v) { out.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+    void str(std::string_view s) {
+        u32(static_cast<uint32_t>(s.size()));
+        out.append(s);
+    }
+    std::string out;
+};
+
+struct RequestReader {
+    explicit RequestReader(std::string_view in) : in(in) {}
+
+    uint32_t u32() {
+        uint32_t v = 0;
+        if (in.size() - pos < sizeof(v)) {
+            ok = false;
+            return 0;
+        }
+        std::memcpy(&v, in.data() + pos, sizeof(v));
+        pos += sizeof(v);
+        return v;
+    }
+
+    std::string str() {
+        uint32_t size = u32();
+        if (in.size() - pos < size) {
+            ok = false;
+            return {};
+        }
+        std::string s(in.substr(pos, size));
+        pos += size;
+        return s;
+    }
+
+    std::string_view in;
+    size_t pos = 0;
+    bool ok = true;
+};
+
+bool writeAll(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size) {
+        ssize_t n = ::send(fd, p, size, SendFlags);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool readAll(int fd, void* data, size_t size) {
+    char* p = static_cast<char*>(data);
+    while (size) {
+        ssize_t n = ::read(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool socketAddress(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) return false;
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.data(), path.size());
+    return true;
+}
+
+int openSocket() {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0)
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return fd;
+}
+
+int connectTo(const std::string& path) {
+    sockaddr_un addr;
+    if (!socketAddress(path, addr)) return -1;
+    int fd = openSocket();
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// The command byte, carrying this process's stdout and stderr for RUN.
+bool sendCommand(int fd, Command command) {
+    char byte = static_cast<char>(command);
+    iovec iov{&byte, 1};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+    if (command == Command::RUN) {
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(2 * sizeof(int));
+        int fds[2] = {STDOUT_FILENO, STDERR_FILENO};
+        std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    }
+
+    while (::sendmsg(fd, &msg, SendFlags) < 0) {
+        if (errno != EINTR) return false;
+    }
+    return true;
+}
+
+// The command byte and the descriptors sent with it (-1 when there were
+// none).
+bool receiveCommand(int fd, Command& command, int fds[2]) {
+    fds[0] = fds[1] = -1;
+
+    char byte = 0;
+    iovec iov{&byte, 1};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))];
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = ::recvmsg(fd, &msg, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n != 1) return false;
+
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+            cmsg->cmsg_len == CMSG_LEN(2 * sizeof(int)))
+            std::memcpy(fds, CMSG_DATA(cmsg), 2 * sizeof(int));
+    }
+    command = static_cast<Command>(byte);
+    return true;
+}
+
+// Whether the process on the other end runs as the same user as this one.
+// A request can LOADDLL anything, so it runs code as the server's owner.
+bool sameUser(int fd) {
+#ifdef SO_PEERCRED
+    ucred cred{};
+    socklen_t length = sizeof(cred);
+    return ::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &length) == 0 && cred.uid == ::geteuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    return ::getpeereid(fd, &uid, &gid) == 0 && uid == ::geteuid();
+#endif
+}
+
+void closeDescriptors(int fds[2]) {
+    for (int i = 0; i < 2; i++)
+        if (fds[i] >= 0) ::close(fds[i]);
+}
+
+void flushStandardStreams() {
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+}
+
+// Runs one request with the client's descriptors in place of stdout and
+// stderr, from the client's working directory.
+int run(const Server::Handler& handler, int fds[2], const std::string& cwd,
+        const std::vector<std::string>& args, const std::string& source, const std::string& home) {
+    flushStandardStreams();
+    int savedOut = ::dup(STDOUT_FILENO);
+    int savedErr = ::dup(STDERR_FILENO);
+    ::dup2(fds[0], STDOUT_FILENO);
+    ::dup2(fds[1], STDERR_FILENO);
+    closeDescriptors(fds);
+
+    int status = 1;
+    if (::chdir(cwd.c_str()) != 0) {
+        std::cerr << "Failed to enter " << cwd << '\n';
+    } else {
+        std::istringstream in(source);
+        try {
+            status = handler(args, in);
+        } catch (const std::exception& e) {
+            std::cerr << "JorgeScript Error: " << e.what() << '\n';
+        }
+    }
+
+    flushStandardStreams();
+    ::dup2(savedOut, STDOUT_FILENO);
+    ::dup2(savedErr, STDERR_FILENO);
+    ::close(savedOut);
+    ::close(savedErr);
+    if (::chdir(home.c_str()) != 0)
+        std::cerr << "Failed to return to " << home << '\n';
+    return status;
+}
+
+// Serves one connection. Returns true when the client asked the server to
+// stop.
+bool handle(int client, const Server::Handler& handler, const std::string& home) {
+    Command command;
+    int fds[2];
+    if (!receiveCommand(client, command, fds)) return false;
+
+    if (command == Command::STOP) {
+        closeDescriptors(fds);
+        int32_t status = 0;
+        writeAll(client, &status, sizeof(status));
+        return true;
+    }
+
+    uint32_t length = 0;
+    std::string body;
+    bool received = command == Command::RUN && fds[0] >= 0 && fds[1] >= 0 &&
+                    readAll(client, &length, sizeof(length)) && length <= MaxRequest;
+    if (received) {
+        body.resize(length);
+        received = readAll(client, body.data(), length);
+    }
+
+    RequestReader r(body);
+    std::string cwd = r.str();
+    uint32_t argc = r.u32();
+    if (argc > body.size()) r.ok = false;
+    std::vector<std::string> args(r.ok ? argc : 0);
+    for (std::string& arg : args) {
+        if (!r.ok) break;
+        arg = r.str();
+    }
+    std::string source = r.u32() ? r.str() : std::string();
+    if (!received || !r.ok) {
+        closeDescriptors(fds);
+        return false;
+    }
+
+    int32_t status = run(handler, fds, cwd, args, source, home);
+    writeAll(client, &status, sizeof(status));
+    return false;
+}
+
+// Starts `self --serve path` outside this process's session, with its
+// standard streams on /dev/null. The intermediate child exits right away so
+// the server is not left as this process's child.
+bool spawn(const std::string& path, const std::string& self) {
+    pid_t child = ::fork();
+    if (child < 0) return false;
+
+    if (child == 0) {
+        ::setsid();
+        if (::fork() != 0) ::_exit(0);
+
+        int null = ::open("/dev/null", O_RDWR);
+        if (null >= 0) {
+            ::dup2(null, STDIN_FILENO);
+            ::dup2(null, STDOUT_FILENO);
+            ::dup2(null, STDERR_FILENO);
+            if (null > STDERR_FILENO) ::close(null);
+        }
+        ::execlp(self.c_str(), self.c_str(), "--serve", path.c_str(), static_cast<char*>(nullptr));
+        ::_exit(127);
+    }
+
+    int status;
+    while (::waitpid(child, &status, 0) < 0 && errno == EINTR) {}
+    return true;
+}
+
+} // namespace
+
+bool Server::available() { return true; }
+
+int Server::serve(const std::string& socketPath, const Handler& handler) {
+    sockaddr_un addr;
+    if (!socketAddress(socketPath, addr)) {
+        std::cerr << "Invalid socket path: " << socketPath << '\n';
+        return 1;
+    }
+
+    // A socket file nobody answers on was left behind by a server that
+    // died; one that answers belongs to a running server.
+    int probe = connectTo(socketPath);
+    if (probe >= 0) {
+        ::close(probe);
+        std::cerr << "A server is already listening on " << socketPath << '\n';
+        return 1;
+    }
+    ::unlink(socketPath.c_str());
+
+    // The socket is created 0600, so other users cannot even connect.
+    int listener = openSocket();
+    mode_t mask = ::umask(0177);
+    bool bound = listener >= 0 && ::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    ::umask(mask);
+    if (!bound || ::listen(listener, 16) < 0) {
+        std::cerr << "Failed to listen on " << socketPath << ": " << std::strerror(errno) << '\n';
+        if (listener >= 0) ::close(listener);
+        return 1;
+    }
+
+    // A client that goes away mid-run must not take the server with it.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::error_code ec;
+    std::string home = std::filesystem::current_path(ec).string();
+
+    bool stopping = false;
+    while (!stopping) {
+        int client = ::accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::cerr << "Failed to accept on " << socketPath << ": " << std::strerror(errno) << '\n';
+            break;
+        }
+        ::fcntl(client, F_SETFD, FD_CLOEXEC);
+        if (!sameUser(client)) {
+            ::close(client);
+            continue;
+        }
+        timeval timeout{RequestTimeoutSeconds, 0};
+        ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        stopping = handle(client, handler, home);
+        ::close(client);
+    }
+
+    ::close(listener);
+    ::unlink(socketPath.c_str());
+    return stopping ? 0 : 1;
+}
+
+int Server::request(const std::string& socketPath, const std::string& self,
+                    const std::vector<std::string>& args, const std::string* source) {
+    int fd = connectTo(socketPath);
+    if (fd < 0 && spawn(socketPath, self)) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while ((fd = connectTo(socketPath)) < 0 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (fd < 0) return -1;
+
+    std::error_code ec;
+    RequestWriter w;
+    w.str(std::filesystem::current_path(ec).string());
+    w.u32(static_cast<uint32_t>(args.size()));
+    for (const std::string& arg : args)
+        w.str(arg);
+    w.u32(source ? 1 : 0);
+    if (source) w.str(*source);
+
+    // Whatever this process has buffered goes out before the server writes
+    // to the same descriptors.
+    flushStandardStreams();
+
+    uint32_t length = static_cast<uint32_t>(w.out.size());
+    if (!sendCommand(fd, Command::RUN) || !writeAll(fd, &length, sizeof(length)) ||
+        !writeAll(fd, w.out.data(), w.out.size())) {
+        ::close(fd);
+        return -1;
+    }
+
+    int32_t status = 0;
+    bool answered = readAll(fd, &status, sizeof(status));
+    ::close(fd);
+    if (!answered) {
+        std::cerr << "Lost the connection to the server on " << socketPath << '\n';
+        return 1;
+    }
+    return status;
+}
+
+bool Server::stop(const std::string& socketPath) {
+    int fd = connectTo(socketPath);
+    if (fd < 0) return false;
+
+    int32_t status = 0;
+    bool stopped = sendCommand(fd, Command::STOP) && readAll(fd, &status, sizeof(status));
+    ::close(fd);
+    return stopped;
+}
+
+#endif
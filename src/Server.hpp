@@ -0,0 +1,40 @@
+#pragma once
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+// A long-lived interpreter behind a Unix domain socket (--serve). Modules
+// parsed and libraries opened by one run stay warm for the next.
+//
+// A request carries the client's command line, its working directory and,
+// for a script read from stdin (`-`), the source text. The client's stdout
+// and stderr travel along as file descriptors, so PRINT, foreign code and
+// error messages write straight to the client's own terminal or pipe. The
+// reply is the exit status. Requests are served one at a time.
+//
+// Only the user running the server can connect: the socket is created
+// 0600 and clients of another user are dropped.
+class Server {
+public:
+    // Runs one request: the command line and the text the script may read
+    // as stdin. Returns the exit status.
+    using Handler = std::function<int(const std::vector<std::string>& args, std::istream& in)>;
+
+    // Whether this build has Unix domain sockets (not on Windows).
+    static bool available();
+
+    // Serves requests on `socketPath` until a client asks it to stop.
+    // Returns non-zero when the socket cannot be bound.
+    static int serve(const std::string& socketPath, const Handler& handler);
+
+    // Runs `args` in the server listening on `socketPath`, starting one as
+    // `self --serve socketPath` in the background when none is. `source` is
+    // sent as the script's stdin. Returns the exit status, or -1 when no
+    // server could be reached.
+    static int request(const std::string& socketPath, const std::string& self,
+                       const std::vector<std::string>& args, const std::string* source);
+
+    // Asks the server on `socketPath` to exit. False when none is running.
+    static bool stop(const std::string& socketPath);
+};
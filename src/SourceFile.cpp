@@ -0,0 +1,101 @@
+#include "SourceFile.hpp"
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+SourceFile::SourceFile(const std::string& filename) {
+    HANDLE h = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Failed to open file: " + filename);
+    file = h;
+
+    LARGE_INTEGER length;
+    if (GetFileType(h) != FILE_TYPE_DISK || !GetFileSizeEx(h, &length) || length.QuadPart == 0) {
+        char buffer[65536];
+        DWORD n;
+        while (ReadFile(h, buffer, sizeof(buffer), &n, nullptr) && n > 0)
+            owned.append(buffer, n);
+        data = owned.data();
+        size = owned.size();
+        return;
+    }
+    size = static_cast<size_t>(length.QuadPart);
+
+    mapping = CreateFileMappingA(h, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping)
+        data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!data) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(h);
+        throw std::runtime_error("Failed to map file: " + filename);
+    }
+    mapped = true;
+}
+
+SourceFile::~SourceFile() {
+    if (mapped) UnmapViewOfFile(data);
+    if (mapping) CloseHandle(mapping);
+    if (file) CloseHandle(file);
+}
+
+#else
+
+SourceFile::SourceFile(const std::string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Failed to open file: " + filename);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+
+    if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+        char buffer[65536];
+        ssize_t n;
+        while ((n = read(fd, buffer, sizeof(buffer))) != 0) {
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) {
+                close(fd);
+                throw std::runtime_error("Failed to read file: " + filename);
+            }
+            owned.append(buffer, static_cast<size_t>(n));
+        }
+        close(fd);
+        data = owned.data();
+        size = owned.size();
+        return;
+    }
+    size = static_cast<size_t>(st.st_size);
+
+    void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Failed to map file: " + filename);
+    }
+    madvise(view, size, MADV_SEQUENTIAL);
+    data = static_cast<const char*>(view);
+    mapped = true;
+
+    close(fd);
+}
+
+SourceFile::~SourceFile() {
+    if (mapped) munmap(const_cast<char*>(data), size);
+}
+
+#endif
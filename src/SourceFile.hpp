@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// A script mapped read-only into memory. Tokens produced by the Lexer point
+// straight into this buffer, so it has to outlive lexing and parsing.
+// Pipes, devices and other files that cannot be mapped (or report a size of
+// 0, like /proc) are read into a buffer of its own instead.
+class SourceFile {
+public:
+    explicit SourceFile(const std::string& filename);
+    ~SourceFile();
+
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    std::string_view text() const { return {data, size}; }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    std::string owned;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
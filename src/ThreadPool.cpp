@@ -0,0 +1,143 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) threads = 1;
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; i++)
+        workers.emplace_back([this] { work(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (std::thread& t : workers)
+        t.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    available.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return tasks.empty() && running == 0; });
+}
+
+void ThreadPool::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        available.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (tasks.empty()) return;
+
+        std::function<void()> task = std::move(tasks.front());
+        tasks.pop_front();
+        running++;
+
+        lock.unlock();
+        task();
+        lock.lock();
+
+        running--;
+        if (tasks.empty() && running == 0)
+            idle.notify_all();
+    }
+}
+
+StealingPool::StealingPool(size_t threads) : threads(threads ? threads : 1), queues(new Queue[this->threads]) {
+    workers.reserve(this->threads - 1);
+    for (size_t i = 1; i < this->threads; i++)
+        workers.emplace_back([this, i] { work(i); });
+}
+
+StealingPool::~StealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    started.notify_all();
+    for (std::thread& t : workers)
+        t.join();
+}
+
+void StealingPool::run(size_t count, const Task& task) {
+    size_t used = std::min(threads, count);
+    for (size_t t = 0; t < used; t++) {
+        std::lock_guard<std::mutex> lock(queues[t].mutex);
+        for (size_t i = count * t / used; i < count * (t + 1) / used; i++)
+            queues[t].tasks.push_back(i);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &task;
+        width = used;
+        generation++;
+        active++;
+    }
+    started.notify_all();
+
+    drain(0);
+
+    // A worker that took a task is active until it has finished it, so
+    // nobody still uses `task` once this returns.
+    std::unique_lock<std::mutex> lock(mutex);
+    active--;
+    finished.wait(lock, [this] { return active == 0; });
+    job = nullptr;
+}
+
+void StealingPool::work(size_t thread) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        started.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        if (!job || thread >= width) continue;
+        active++;
+
+        lock.unlock();
+        drain(thread);
+        lock.lock();
+
+        if (--active == 0)
+            finished.notify_all();
+    }
+}
+
+void StealingPool::drain(size_t thread) {
+    const Task& task = *job;
+    size_t index;
+    while (next(thread, index))
+        task(index, thread);
+}
+
+bool StealingPool::next(size_t thread, size_t& task) {
+    {
+        Queue& own = queues[thread];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    for (size_t k = 1; k < width; k++) {
+        Queue& victim = queues[(thread + k) % width];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
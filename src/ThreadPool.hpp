@@ -0,0 +1,81 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads draining a shared queue. Tasks may submit
+// further tasks; wait() returns once the queue is empty and every worker
+// is idle.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+    void wait();
+
+    size_t size() const { return workers.size(); }
+
+private:
+    void work();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable available;
+    std::condition_variable idle;
+    size_t running = 0;
+    bool stopping = false;
+};
+
+// Runs the tasks 0..count-1 of one parallel loop on a fixed set of
+// threads, the caller being thread 0. Every thread starts with its own
+// contiguous share of the tasks, taken from the front of its deque; one
+// that runs dry steals from the back of another's, so uneven tasks still
+// keep every thread busy. Only the first `count` threads take part in a
+// run of fewer tasks than threads. run() returns once all tasks are done.
+class StealingPool {
+public:
+    // `task(index, thread)`. It must not throw.
+    using Task = std::function<void(size_t task, size_t thread)>;
+
+    explicit StealingPool(size_t threads = std::thread::hardware_concurrency());
+    ~StealingPool();
+
+    StealingPool(const StealingPool&) = delete;
+    StealingPool& operator=(const StealingPool&) = delete;
+
+    void run(size_t count, const Task& task);
+
+    size_t size() const { return threads; }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    void work(size_t thread);
+    void drain(size_t thread);
+    bool next(size_t thread, size_t& task);
+
+    size_t threads;
+    std::unique_ptr<Queue[]> queues;
+    std::vector<std::thread> workers;
+    const Task* job = nullptr;
+    size_t width = 0;
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+    uint64_t generation = 0;
+    size_t active = 0;
+    bool stopping = false;
+};
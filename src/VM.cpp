@@ -0,0 +1,262 @@
+#include "VM.hpp"
+#include "Interpreter.hpp"
+#include "Runtime.hpp"
+#include <stdexcept>
+
+namespace {
+bool forInRange(double i, double end, double step) {
+    return (step > 0 && i <= end) || (step < 0 && i >= end);
+}
+
+} // namespace
+
+Value VM::pop() {
+    Value v = std::move(stack.back());
+    stack.pop_back();
+    return v;
+}
+
+void VM::run(const Chunk& chunk) {
+    const Instruction* code = chunk.code.data();
+    size_t ip = 0;
+
+    for (;;) {
+        const Instruction& ins = code[ip++];
+
+        switch (ins.op) {
+            case OpCode::CONSTANT:
+                stack.push_back(chunk.constants[ins.a]);
+                break;
+
+            case OpCode::LOAD: {
+                // A number in this frame's own slot is pushed without the
+                // refcount checks of a Value copy.
+                const Variable& own = in.scopes.back().slots[ins.a];
+                if (own.defined && own.value.type == ValueType::NUMBER) [[likely]] {
+                    stack.emplace_back(own.value.number);
+                    break;
+                }
+                stack.push_back(in.loadVariable(ins.a, chunk.slotNames[ins.a]));
+                break;
+            }
+
+            case OpCode::LOAD_COUNTER: {
+                double i = stack[ins.b].number;
+                stack.emplace_back(i);
+                break;
+            }
+
+            case OpCode::STORE: {
+                // A plain SET of a defined, non-constant variable in this frame
+                // is all assignVariable would do; move the value straight in.
+                Variable& own = in.scopes.back().slots[ins.a];
+                if (!ins.flags && own.defined && !own.isconstant) [[likely]] {
+                    own.value = std::move(stack.back());
+                    stack.pop_back();
+                    break;
+                }
+                in.assignVariable(ins.a, chunk.slotNames[ins.a], stack.back(),
+                               (ins.flags & STORE_CONSTANT) != 0,
+                               (ins.flags & STORE_LOCAL) != 0);
+                stack.pop_back();
+                break;
+            }
+
+            case OpCode::STORE_ELEMENT: {
+                size_t top = stack.size();
+                in.storeElement(ins.a, chunk.slotNames[ins.a], stack[top - 2], stack[top - 1]);
+                stack.resize(top - 2);
+                break;
+            }
+
+            case OpCode::ADD: {
+                size_t top = stack.size();
+                Value& l = stack[top - 2];
+                const Value& r = stack[top - 1];
+                if (l.type == ValueType::NUMBER && r.type == ValueType::NUMBER) [[likely]]
+                    l.number += r.number;
+                else
+                    l = addValues(l, r);
+                stack.pop_back();
+                break;
+            }
+
+            case OpCode::EQUAL: {
+                size_t top = stack.size();
+                Value& l = stack[top - 2];
+                const Value& r = stack[top - 1];
+                if (l.type == ValueType::NUMBER && r.type == ValueType::NUMBER)
+                    l = Value(l.number == r.number);
+                else if (l.type == ValueType::BOOLEAN && r.type == ValueType::BOOLEAN)
+                    l = Value(l.boolean == r.boolean);
+                else
+                    l = equalValues(l, r);
+                stack.pop_back();
+                break;
+            }
+
+            case OpCode::ARRAY_OF: {
+                size_t first = stack.size() - ins.b;
+                Value array = arrayOf(stack.data() + first, ins.b);
+                stack.resize(first);
+                stack.push_back(std::move(array));
+                break;
+            }
+
+            case OpCode::ZEROS:
+                stack.back() = zeros(stack.back());
+                break;
+
+            case OpCode::INDEX: {
+                size_t top = stack.size();
+                stack[top - 2] = elementOf(stack[top - 2], stack[top - 1]);
+                stack.pop_back();
+                break;
+            }
+
+            case OpCode::LENGTH:
+                stack.back() = lengthOf(stack.back());
+                break;
+
+            case OpCode::PRINT:
+                in.print(stack.back());
+                stack.pop_back();
+                break;
+
+            case OpCode::JUMP:
+                if (ins.b < ip && in.options.jit) [[unlikely]] {
+                    ip = Jit::enter(in, chunk, static_cast<uint32_t>(ip - 1), ins.b, stack);
+                    break;
+                }
+                ip = ins.b;
+                break;
+
+            case OpCode::JUMP_IF_FALSE: {
+                const Value& cond = stack.back();
+                if (cond.type != ValueType::BOOLEAN)
+                    throw std::runtime_error("IF condition must be boolean");
+                if (!cond.boolean) ip = ins.b;
+                stack.pop_back();
+                break;
+            }
+
+            case OpCode::JUMP_UNLESS_TRUE:
+                if (!stack.back().isTrue()) ip = ins.b;
+                stack.pop_back();
+                break;
+
+            case OpCode::FOR_PREP: {
+                Value stepVal = pop();
+                Value endVal = pop();
+                Value startVal = pop();
+
+                if (startVal.type != ValueType::NUMBER || endVal.type != ValueType::NUMBER || stepVal.type != ValueType::NUMBER)
+                    throw std::runtime_error("FOR loop bounds must be numbers");
+
+                stack.push_back(startVal);
+                stack.push_back(endVal);
+                stack.push_back(stepVal);
+
+                if (!forInRange(startVal.number, endVal.number, stepVal.number))
+                    ip = ins.b;
+                else if (!(ins.flags & FOR_COUNTED))
+                    in.setLoopVariable(ins.a, startVal.number);
+                break;
+            }
+
+            case OpCode::FOR_LOOP: {
+                Value* state = stack.data() + stack.size() - 3;
+                double i = state[0].number += state[2].number;
+                bool more = (ins.flags & FOR_ASCENDING) ? i <= state[1].number
+                                                        : forInRange(i, state[1].number, state[2].number);
+                if (more) {
+                    if (!(ins.flags & FOR_COUNTED))
+                        in.setLoopVariable(ins.a, i);
+                    ip = ins.b;
+                    if (in.options.jit) [[unlikely]]
+                        ip = Jit::enter(in, chunk, static_cast<uint32_t>(&ins - code), ins.b, stack);
+                }
+                break;
+            }
+
+            case OpCode::FOR_END:
+                stack.resize(stack.size() - 3);
+                in.eraseLoopVariable(ins.a);
+                break;
+
+            case OpCode::PARALLEL_FOR: {
+                size_t top = stack.size();
+                in.runParallel(*chunk.parallels[ins.b], stack[top - 3], stack[top - 2], stack[top - 1]);
+                stack.resize(top - 3);
+                break;
+            }
+
+            case OpCode::LOAD_DLL:
+                in.loadLibrary(chunk.names[ins.a], chunk.names[ins.b]);
+                break;
+
+            case OpCode::CALL_DLL: {
+                Value result = in.callLibrary(*chunk.calls[ins.b], stack.data() + stack.size() - ins.flags, ins.flags);
+                stack.resize(stack.size() - ins.flags);
+                stack.push_back(std::move(result));
+                break;
+            }
+
+            case OpCode::ASYNC_CALL: {
+                double handle = in.startCall(*chunk.calls[ins.b], stack.data() + stack.size() - ins.flags, ins.flags);
+                stack.resize(stack.size() - ins.flags);
+                stack.emplace_back(handle);
+                break;
+            }
+
+            case OpCode::AWAIT:
+                stack.back() = in.awaitCall(stack.back());
+                break;
+
+            case OpCode::DECLARE:
+                in.declareFunction(*chunk.declarations[ins.b]);
+                break;
+
+            case OpCode::POP:
+                stack.pop_back();
+                break;
+
+            case OpCode::CALL_EXPR:
+                in.output.write("CallExpr: ");
+                in.output.write(chunk.names[ins.a]);
+                in.output.write("()");
+                in.output.endLine();
+                stack.emplace_back();
+                break;
+
+            case OpCode::SUMMON: {
+                const Chunk& module = in.modules.get(chunk.names[ins.a]).compiled(in.profiler.enabled);
+
+                in.pushScope(module.slotNames);
+
+                if (in.profiler.enabled) in.profiler.pushFile(chunk.names[ins.a]);
+                VM(in).run(module);
+                if (in.profiler.enabled) in.profiler.popFile();
+
+                const std::string& alias = chunk.names[ins.b];
+                if (!alias.empty()) {
+                    in.fileScopes[alias] = in.scopes.back();
+                }
+
+                in.popScope();
+                break;
+            }
+
+            case OpCode::PROFILE_ENTER:
+                in.profiler.enter(chunk.statements[ins.b]);
+                break;
+
+            case OpCode::PROFILE_EXIT:
+                in.profiler.exit();
+                break;
+
+            case OpCode::HALT:
+                return;
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <vector>
+
+#include "AST.hpp"
+#include "Bytecode.hpp"
+
+class Interpreter;
+
+class VM {
+public:
+    explicit VM(Interpreter& in) : in(in) {}
+
+    void run(const Chunk& chunk);
+
+private:
+    Interpreter& in;
+    std::vector<Value> stack;
+
+    Value pop();
+};
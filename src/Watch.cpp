@@ -0,0 +1,249 @@
+#include "Watch.hpp"
+#include "Runtime.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+// How long the files have to stay quiet before a batch of changes is
+// handed out. Editors often write a file in several steps.
+constexpr int SettleMillis = 30;
+} // namespace
+
+bool FileWatcher::available() { return true; }
+
+FileWatcher::FileWatcher() : fd(inotify_init1(IN_CLOEXEC | IN_NONBLOCK)) {}
+
+FileWatcher::~FileWatcher() {
+    if (fd >= 0) close(fd);
+}
+
+void FileWatcher::watch(const std::vector<std::string>& paths) {
+    files.clear();
+    NameMap<int> wanted;
+    for (const std::string& path : paths) {
+        files.insert(path);
+        wanted.emplace(std::filesystem::path(path).parent_path().string(), -1);
+    }
+    if (fd < 0) return;
+
+    for (auto it = directories.begin(); it != directories.end();) {
+        if (wanted.count(it->first)) {
+            ++it;
+            continue;
+        }
+        inotify_rm_watch(fd, it->second);
+        std::erase_if(descriptors, [&](const auto& d) { return d.first == it->second; });
+        it = directories.erase(it);
+    }
+    for (const auto& [directory, unused] : wanted) {
+        if (directories.count(directory)) continue;
+        int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0) continue;
+        directories.emplace(directory, wd);
+        descriptors.emplace_back(wd, directory);
+    }
+}
+
+std::vector<std::string> FileWatcher::wait() {
+    struct stat input{};
+    bool pipe = fstat(STDIN_FILENO, &input) == 0 && S_ISFIFO(input.st_mode);
+
+    std::vector<std::string> changed;
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        pollfd fds[2] = {{fd, POLLIN, 0}, {STDIN_FILENO, POLLIN, 0}};
+        int ready = poll(fds, pipe ? 2 : 1, changed.empty() ? -1 : SettleMillis);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready < 0) return {};
+        if (ready == 0) return changed;
+
+        if (pipe && (fds[1].revents & (POLLIN | POLLHUP))) {
+            char discard[256];
+            if (read(STDIN_FILENO, discard, sizeof(discard)) <= 0) return {};
+        }
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        ssize_t size;
+        while ((size = read(fd, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + size;) {
+                auto* event = reinterpret_cast<inotify_event*>(p);
+                p += sizeof(inotify_event) + event->len;
+                if (event->len == 0) continue;
+                auto d = std::find_if(descriptors.begin(), descriptors.end(),
+                                      [&](const auto& d) { return d.first == event->wd; });
+                if (d == descriptors.end()) continue;
+                std::string path = (std::filesystem::path(d->second) / event->name).string();
+                if (files.count(path) && std::find(changed.begin(), changed.end(), path) == changed.end())
+                    changed.push_back(std::move(path));
+            }
+        }
+    }
+}
+
+#else
+
+bool FileWatcher::available() { return false; }
+
+FileWatcher::FileWatcher() {}
+
+FileWatcher::~FileWatcher() {}
+
+void FileWatcher::watch(const std::vector<std::string>&) {}
+
+std::vector<std::string> FileWatcher::wait() { return {}; }
+
+#endif
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double millis(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+std::string canonicalPath(const std::string& filename) {
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(filename, ec);
+    return ec ? filename : canonical.string();
+}
+
+} // namespace
+
+WatchSession::WatchSession(Interpreter& in, const std::string& path)
+    : in(in), path(path), key(canonicalPath(path)) {}
+
+int WatchSession::run() {
+    std::cout << "Running JorgeScript\n";
+    if (parseEntry()) {
+        in.modules.prefetch(entry, std::thread::hardware_concurrency());
+        runFrom(0);
+    }
+
+    FileWatcher watcher;
+    while (true) {
+        watcher.watch(watched());
+        std::vector<std::string> changed = watcher.wait();
+        if (changed.empty()) return 0;
+        reload(changed);
+    }
+}
+
+bool WatchSession::parseEntry() {
+    try {
+        entry = parseFile(path);
+    } catch (const std::exception& e) {
+        std::cerr << "JorgeScript Error: " << e.what() << '\n';
+        return false;
+    }
+    parsed = true;
+    completed = 0;
+
+    segments.clear();
+    size_t count = entry.statements.size();
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0 && !dynamic_cast<SummonStatement*>(entry.statements[i])) continue;
+        if (!segments.empty()) segments.back().last = i;
+        Segment& segment = segments.emplace_back();
+        segment.first = i;
+        segment.last = count;
+    }
+    return true;
+}
+
+void WatchSession::runFrom(size_t segment) {
+    in.finishCalls();
+    if (segment == 0) {
+        in.scopes.clear();
+        in.pushScope(entry.slotNames);
+        in.fileScopes.clear();
+    } else {
+        in.scopes = segments[segment].frames;
+        in.fileScopes = segments[segment].fileScopes;
+    }
+
+    completed = segment;
+    try {
+        for (; completed < segments.size(); completed++) {
+            Segment& s = segments[completed];
+            if (completed != segment || segment == 0) {
+                s.frames = in.scopes;
+                s.fileScopes = in.fileScopes;
+            }
+            s.reached.clear();
+            in.modules.trace = &s.reached;
+            in.runPart(entry, s.first, s.last);
+        }
+        in.modules.trace = nullptr;
+        in.finishCalls();
+    } catch (const std::exception& e) {
+        in.modules.trace = nullptr;
+        in.sync();
+        std::cerr << "JorgeScript Error: " << e.what() << '\n';
+    }
+    in.sync();
+}
+
+void WatchSession::reload(const std::vector<std::string>& changed) {
+    Clock::time_point start = Clock::now();
+    bool fromTop = !parsed || std::find(changed.begin(), changed.end(), key) != changed.end();
+
+    // Only the files that changed are parsed again.
+    try {
+        for (const std::string& file : changed)
+            if (file != key) in.modules.reload(file);
+    } catch (const std::exception& e) {
+        std::cerr << "JorgeScript Error: " << e.what() << '\n';
+        return;
+    }
+    if (fromTop && !parseEntry()) return;
+
+    // The PARALLEL FOR workers keep modules of their own.
+    in.workers.clear();
+
+    size_t from = 0;
+    if (fromTop) {
+        in.reset();
+        in.modules.prefetch(entry, std::thread::hardware_concurrency());
+    } else {
+        // A segment that failed has reached what it reached so far.
+        size_t ran = std::min(completed + 1, segments.size());
+        for (from = 0; from < ran; from++) {
+            const std::unordered_set<std::string>& reached = segments[from].reached;
+            if (std::any_of(changed.begin(), changed.end(), [&](const std::string& f) { return reached.count(f); }))
+                break;
+        }
+        if (from == ran) return;
+    }
+    Clock::time_point parsedAt = Clock::now();
+
+    runFrom(from);
+    Clock::time_point done = Clock::now();
+
+    std::cerr << "watch: reloaded";
+    for (const std::string& file : changed)
+        std::cerr << ' ' << file;
+    char line[160];
+    std::snprintf(line, sizeof(line), " in %.3f ms (parse %.3f ms, run %.3f ms from segment %zu of %zu)\n",
+                  millis(done - start), millis(parsedAt - start), millis(done - parsedAt), from + 1, segments.size());
+    std::cerr << line;
+}
+
+std::vector<std::string> WatchSession::watched() const {
+    std::unordered_set<std::string> files{key};
+    size_t ran = std::min(completed + 1, segments.size());
+    for (size_t s = 0; s < ran; s++)
+        files.insert(segments[s].reached.begin(), segments[s].reached.end());
+    return {files.begin(), files.end()};
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "AST.hpp"
+#include "Interpreter.hpp"
+
+// Waits for files to change, through inotify. The directories holding the
+// files are watched rather than the files, so an editor that saves by
+// renaming a new file over the old one is still seen.
+class FileWatcher {
+public:
+    // Whether this build can watch files (Linux only).
+    static bool available();
+
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Watches exactly `paths` (canonical) from now on.
+    void watch(const std::vector<std::string>& paths);
+
+    // Blocks until watched files change and returns them, once no more
+    // changes came for a moment, so one save is one batch. Returns nothing
+    // when stdin is a pipe and its writer closed it.
+    std::vector<std::string> wait();
+
+private:
+    int fd = -1;
+    // Watch descriptors by directory, and the other way round.
+    NameMap<int> directories;
+    std::vector<std::pair<int, std::string>> descriptors;
+    std::unordered_set<std::string> files;
+};
+
+// Runs a script, then runs it again whenever it or a module it SUMMONs
+// changes (--watch).
+//
+// The script runs in segments, each starting at one of its top-level
+// SUMMON statements, and the frames and FileScopes a segment started from
+// are kept. When a module changes, only that file is parsed again and the
+// run resumes from the first segment that SUMMONed it, directly or through
+// other modules: earlier segments are not run again and keep what they
+// set. A change to the script itself runs it from the top, with every
+// unchanged module still parsed.
+class WatchSession {
+public:
+    WatchSession(Interpreter& in, const std::string& path);
+
+    // Returns when stdin is a pipe that closed; otherwise runs until the
+    // process is interrupted.
+    int run();
+
+private:
+    struct Segment {
+        // Top-level statements [first, last).
+        size_t first = 0;
+        size_t last = 0;
+        std::vector<Scope> frames;
+        NameMap<Scope> fileScopes;
+        // Modules this segment SUMMONed on its last run.
+        std::unordered_set<std::string> reached;
+    };
+
+    bool parseEntry();
+    void runFrom(size_t segment);
+    void reload(const std::vector<std::string>& changed);
+    std::vector<std::string> watched() const;
+
+    Interpreter& in;
+    std::string path;
+    std::string key;
+    Program entry;
+    bool parsed = false;
+    std::vector<Segment> segments;
+    // Segments that ran to the end on the last run.
+    size_t completed = 0;
+};
@@ -1,38 +1,244 @@
+#include "Interpreter.hpp"
 #include "Lexer.hpp"
-#include "Parser.hpp"
+#include "Optimizer.hpp"
 #include "Runtime.hpp"
-#include <fstream>
+#include "ScriptCache.hpp"
+#include "Server.hpp"
+#include "SourceFile.hpp"
+#include "Watch.hpp"
 #include <iostream>
+#include <iterator>
+#include <optional>
 #include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
-int main(int argc, char** argv) {
-    if (argc < 2) {
-        std::cerr << "Usage: jorgescript <file.jgs>\n";
+namespace {
+const char* Usage =
+    "Usage: jorgescript [--tree-walk] [--jit] [--trace-lexer] [--stats] [--profile] [--profile-folded <file>] "
+    "[--flush line|size|exit] [--threads <n>] [--dump-ast] [--no-optimize] [--no-cache] [--cache-dir <dir>] <file.jgs | ->\n"
+    "       jorgescript --watch [options] <file.jgs>\n"
+    "       jorgescript --serve <socket> [options]\n"
+    "       jorgescript --connect <socket> [--stop | options <file.jgs | ->]\n";
+
+// Puts back the process-wide parsing options a previous request to the
+// server may have changed.
+void resetParsing() {
+    Lexer::trace = false;
+    Optimizer::enabled = true;
+    Optimizer::dump = nullptr;
+    ScriptCache::enabled = true;
+    ScriptCache::directory.clear();
+}
+
+// One run of `interpreter` on a command line (without the program name).
+// A script named `-` is read from `input`.
+int run(Interpreter& interpreter, const std::vector<std::string>& args, std::istream& input) {
+    Interpreter::Options& options = interpreter.options;
+    bool stats = false;
+    bool watch = false;
+    std::string path;
+    std::string foldedPath;
+    options = {};
+    options.flush = Output::defaultPolicy();
+
+    size_t argc = args.size();
+    for (size_t i = 0; i < argc; i++) {
+        const std::string& arg = args[i];
+        if (arg == "--tree-walk")
+            options.treeWalk = true;
+        else if (arg == "--trace-lexer") {
+            Lexer::trace = true;
+            ScriptCache::enabled = false;
+        }
+        else if (arg == "--jit") {
+            options.jit = Jit::available();
+            if (!options.jit)
+                std::cerr << "--jit is not supported on this platform, running interpreted\n";
+        }
+        else if (arg == "--stats")
+            stats = true;
+        else if (arg == "--watch")
+            watch = true;
+        else if (arg == "--profile")
+            options.profile = true;
+        else if (arg == "--profile-folded" && i + 1 < argc) {
+            options.profile = true;
+            foldedPath = args[++i];
+        }
+        else if (arg == "--flush" && i + 1 < argc) {
+            if (!Output::parsePolicy(args[++i], options.flush)) {
+                std::cerr << "Unknown flush policy: " << args[i] << " (line, size or exit)\n";
+                return 1;
+            }
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            const std::string& count = args[++i];
+            if (count.empty() || count.size() > 6 || count.find_first_not_of("0123456789") != std::string::npos) {
+                std::cerr << "Bad thread count: " << count << '\n';
+                return 1;
+            }
+            options.threads = std::stoul(count);
+        }
+        else if (arg == "--dump-ast") {
+            Optimizer::dump = &std::cout;
+            ScriptCache::enabled = false;
+        }
+        else if (arg == "--no-optimize") {
+            Optimizer::enabled = false;
+            ScriptCache::enabled = false;
+        }
+        else if (arg == "--no-cache")
+            ScriptCache::enabled = false;
+        else if (arg == "--cache-dir" && i + 1 < argc)
+            ScriptCache::directory = args[++i];
+        else if (path.empty())
+            path = arg;
+    }
+
+    if (path.empty()) {
+        std::cerr << Usage;
         return 1;
     }
 
-    std::ifstream file(argv[1]);
-    if (!file) {
+    bool fromStdin = path == "-";
+    if (watch) {
+        // A watched script never finishes, so there is no end to report at.
+        if (options.profile || stats) {
+            std::cerr << "--watch cannot be combined with --profile, --profile-folded or --stats\n";
+            return 1;
+        }
+        if (fromStdin || !FileWatcher::available()) {
+            std::cerr << (fromStdin ? "--watch needs a script file\n" : "--watch is not supported on this platform\n");
+            return 1;
+        }
+        return WatchSession(interpreter, path).run();
+    }
+
+    std::optional<SourceFile> source;
+    std::string text;
+    try {
+        if (fromStdin)
+            text.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        else
+            source.emplace(path);
+    } catch (const std::exception&) {
         std::cerr << "Failed to open file\n";
         return 1;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string code = buffer.str();
-
     try {
-        Lexer lexer(code);
-        Parser parser(lexer);
-        auto program = parser.parseProgram();
+        Program program = fromStdin ? parseSource(text) : parseScript(path, source->text());
+        source.reset();
+        if (Optimizer::dump)
+            return 0;
+        interpreter.modules.prefetch(program, std::thread::hardware_concurrency());
 
         std::cout << "Running JorgeScript\n";
-        ScopeStack.clear();
-        pushScope();
-        for (auto& stmt : program)
-            stmt->execute();
+        if (options.profile) interpreter.profiler.pushFile(path);
+        interpreter.run(program);
 
     } catch (const std::exception& e) {
+        interpreter.sync();
         std::cerr << "JorgeScript Error: " << e.what() << '\n';
     }
+    interpreter.sync();
+
+    const ModuleRegistry& modules = interpreter.modules;
+    const Quickening& quickening = interpreter.quickening;
+    const JitStats& jit = interpreter.jitStats;
+
+    if (stats)
+        std::cerr << "modules: " << modules.hits() << " hits, " << modules.misses() << " misses, "
+                  << modules.prefetched() << " prefetched\n";
+    if (stats && options.treeWalk)
+        std::cerr << "quickening: " << quickening.numberAdd << " NumberAdd, " << quickening.stringConcat
+                  << " StringConcat, " << quickening.numberEquals << " NumberEquals, " << quickening.boolEquals
+                  << " BoolEquals, " << quickening.localReads << " local reads, " << quickening.generic
+                  << " generic (" << quickening.guardFailures << " after a guard failure)\n";
+    if (stats && options.jit)
+        std::cerr << "jit: " << jit.compiled << " loops compiled, " << jit.rejected << " rejected, "
+                  << jit.entries << " entries, " << jit.guardFailures << " guard failures\n";
+
+    if (options.profile) {
+        interpreter.profiler.report(std::cerr, 20);
+        if (!foldedPath.empty() && !interpreter.profiler.writeFolded(foldedPath))
+            std::cerr << "Failed to write " << foldedPath << '\n';
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* servePath = nullptr;
+    const char* connectPath = nullptr;
+    bool stop = false;
+    bool fromStdin = false;
+    bool watch = false;
+    std::vector<std::string> args;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--serve" && i + 1 < argc)
+            servePath = argv[++i];
+        else if (arg == "--connect" && i + 1 < argc)
+            connectPath = argv[++i];
+        else if (arg == "--stop")
+            stop = true;
+        else {
+            fromStdin = fromStdin || arg == "-";
+            watch = watch || arg == "--watch";
+            args.push_back(std::move(arg));
+        }
+    }
+
+    if (watch && (servePath || connectPath)) {
+        std::cerr << "--watch runs the script in this process, not through --serve or --connect\n";
+        return 1;
+    }
+
+    if (servePath) {
+        if (!Server::available()) {
+            std::cerr << "--serve is not supported on this platform\n";
+            return 1;
+        }
+        // One interpreter serves every request, so modules and libraries
+        // stay loaded. The server's own options come before those of every
+        // request.
+        Interpreter interpreter;
+        return Server::serve(servePath, [&](const std::vector<std::string>& request, std::istream& input) {
+            resetParsing();
+            interpreter.reset();
+            std::vector<std::string> combined = args;
+            combined.insert(combined.end(), request.begin(), request.end());
+            return run(interpreter, combined, input);
+        });
+    }
+
+    if (connectPath && stop) {
+        if (!Server::stop(connectPath)) {
+            std::cerr << "No server is listening on " << connectPath << '\n';
+            return 1;
+        }
+        return 0;
+    }
+
+    if (connectPath && Server::available()) {
+        std::string source;
+        if (fromStdin)
+            source.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+        int status = Server::request(connectPath, argv[0], args, fromStdin ? &source : nullptr);
+        if (status >= 0)
+            return status;
+
+        std::cerr << "No server on " << connectPath << ", running in this process\n";
+        std::istringstream input(source);
+        Interpreter interpreter;
+        return run(interpreter, args, input);
+    }
+
+    Interpreter interpreter;
+    return run(interpreter, args, std::cin);
 }
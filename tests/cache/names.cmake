@@ -0,0 +1,28 @@
+# Two scripts that differ only in their extension must not share a cache
+# entry: each run after the first has to load its own and print its own
+# text.
+set(dir ${BINARY_DIR}/cache-names)
+file(REMOVE_RECURSE ${dir})
+file(MAKE_DIRECTORY ${dir})
+file(WRITE ${dir}/lib.jorge "PRINT \"from jorge\";\n")
+file(WRITE ${dir}/lib.jgs "PRINT \"from jgs\";\n")
+
+foreach(round 1 2 3)
+    foreach(ext jorge jgs)
+        execute_process(
+            COMMAND ${JORGESCRIPT} ${dir}/lib.${ext}
+            OUTPUT_VARIABLE output
+            ERROR_VARIABLE errors
+        )
+        if (NOT output MATCHES "from ${ext}")
+            message(FATAL_ERROR "lib.${ext} (round ${round}) printed:\n${output}${errors}")
+        endif()
+    endforeach()
+endforeach()
+
+foreach(ext jorge jgs)
+    if (NOT EXISTS ${dir}/lib.${ext}.jgsc)
+        message(FATAL_ERROR "no cache entry lib.${ext}.jgsc")
+    endif()
+endforeach()
+file(REMOVE_RECURSE ${dir})
@@ -0,0 +1,86 @@
+// Runs the script named on the command line in one Interpreter, then in
+// many at once on separate threads with every engine, and fails when any
+// of them prints something else.
+#include "Interpreter.hpp"
+#include "Jit.hpp"
+#include "ScriptCache.hpp"
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+std::string runScript(const std::string& path, Interpreter::Options options) {
+    std::FILE* out = std::tmpfile();
+    if (!out) return "tmpfile failed";
+    options.out = out;
+
+    std::string text;
+    {
+        Interpreter in(options);
+        try {
+            Program program = in.load(path);
+            in.run(program);
+        } catch (const std::exception& e) {
+            in.sync();
+            text = std::string("error: ") + e.what() + "\n";
+        }
+    }
+
+    std::string printed;
+    std::rewind(out);
+    char buffer[4096];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), out)) > 0)
+        printed.append(buffer, n);
+    std::fclose(out);
+    return printed + text;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: jorgescript_embed_test <script> [threads]\n";
+        return 2;
+    }
+    std::string path = argv[1];
+    ScriptCache::enabled = false;
+    unsigned threads = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : 8;
+
+    std::string expected = runScript(path, {});
+    if (expected.empty()) {
+        std::cerr << "the script printed nothing\n";
+        return 1;
+    }
+
+    std::vector<std::string> outputs(threads);
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; i++) {
+        Interpreter::Options options;
+        options.treeWalk = i % 3 == 1;
+        options.jit = i % 3 == 2 && Jit::available();
+        workers.emplace_back([&, i, options] {
+            for (int run = 0; run < 4; run++) {
+                std::string printed = runScript(path, options);
+                if (printed != expected) {
+                    outputs[i] = printed;
+                    return;
+                }
+            }
+        });
+    }
+    for (std::thread& t : workers)
+        t.join();
+
+    int failures = 0;
+    for (unsigned i = 0; i < threads; i++) {
+        if (outputs[i].empty()) continue;
+        std::cerr << "thread " << i << " printed:\n" << outputs[i] << "-- expected:\n" << expected;
+        failures++;
+    }
+    std::cout << threads << " interpreters, " << failures << " failed\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+// Caches the script named on the command line, then damages its .jgsc
+// entry byte by byte and fails when a damaged entry is used or crashes the
+// reader. Each entry is cut short at every length and has every byte
+// flipped. Body bytes are also overwritten, and children dropped (a tag
+// zeroed and the bytes after it removed), with the checksum fixed up, so
+// the reader's own checks (missing children, slots past the frame) are
+// what has to catch them.
+#include "AstPrinter.hpp"
+#include "Compiler.hpp"
+#include "Runtime.hpp"
+#include "ScriptCache.hpp"
+#include "SourceFile.hpp"
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace {
+// Longest child dropped; covers literals and short variable reads.
+constexpr size_t MaxDropped = 24;
+
+uint64_t fnv1a(std::string_view data) {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+void write(const fs::path& path, const std::string& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+// A program the reader accepted has to be whole enough to print and
+// compile; a null child or a bad tag would crash here.
+void use(const Program& program) {
+    std::ostringstream text;
+    AstPrinter(text).block(program.statements);
+    try {
+        Compiler().compile(program);
+    } catch (const std::exception&) {
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: jorgescript_cache_test <script> <cache directory>\n";
+        return 2;
+    }
+    std::string path = argv[1];
+    fs::remove_all(argv[2]);
+    fs::create_directories(argv[2]);
+    ScriptCache::directory = argv[2];
+
+    std::string source;
+    {
+        SourceFile file(path);
+        source = std::string(file.text());
+    }
+    std::optional<CacheKey> key = ScriptCache::keyFor(path, source);
+    if (!key) {
+        std::cerr << "no cache key for " << path << '\n';
+        return 1;
+    }
+    parseFile(path);
+
+    fs::path entry;
+    for (const fs::directory_entry& e : fs::directory_iterator(argv[2]))
+        entry = e.path();
+    std::string intact;
+    {
+        std::ifstream in(entry, std::ios::binary);
+        intact.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    if (!ScriptCache::load(*key)) {
+        std::cerr << "the intact entry was not used\n";
+        return 1;
+    }
+
+    int failures = 0;
+    for (size_t n = 0; n < intact.size(); n++) {
+        write(entry, intact.substr(0, n));
+        if (ScriptCache::load(*key)) {
+            std::cerr << "entry cut to " << n << " bytes was used\n";
+            failures++;
+        }
+    }
+    for (size_t i = 0; i < intact.size(); i++) {
+        std::string damaged = intact;
+        damaged[i] = static_cast<char>(damaged[i] ^ 0x20);
+        write(entry, damaged);
+        if (ScriptCache::load(*key)) {
+            std::cerr << "entry with byte " << i << " flipped was used\n";
+            failures++;
+        }
+    }
+
+    // Magic, version, path, size, mtime and hash, then the checksum.
+    size_t body = 4 + 4 + 4 + key->path.size() + 8 + 8 + 8 + sizeof(uint64_t);
+    size_t accepted = 0;
+    for (size_t i = body; i < intact.size(); i++) {
+        for (unsigned char replacement : {0x00, 0x01, 0xff}) {
+            std::string damaged = intact;
+            damaged[i] = static_cast<char>(replacement);
+            uint64_t checksum = fnv1a(std::string_view(damaged).substr(body));
+            std::memcpy(damaged.data() + body - sizeof(checksum), &checksum, sizeof(checksum));
+            write(entry, damaged);
+            if (std::optional<Program> program = ScriptCache::load(*key)) {
+                use(*program);
+                accepted++;
+            }
+        }
+    }
+    for (size_t i = body; i < intact.size(); i++) {
+        for (size_t dropped = 1; dropped <= MaxDropped && i + dropped < intact.size(); dropped++) {
+            std::string damaged = intact;
+            damaged[i] = 0;
+            damaged.erase(i + 1, dropped);
+            uint64_t checksum = fnv1a(std::string_view(damaged).substr(body));
+            std::memcpy(damaged.data() + body - sizeof(checksum), &checksum, sizeof(checksum));
+            write(entry, damaged);
+            if (std::optional<Program> program = ScriptCache::load(*key)) {
+                use(*program);
+                accepted++;
+            }
+        }
+    }
+
+    fs::remove_all(argv[2]);
+    std::cout << intact.size() << " bytes, " << accepted << " rewritten entries still readable, " << failures
+              << " failed\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+// Serves on the socket named on the command line and, while one client
+// sits connected without sending anything, makes a request from another.
+// Fails when that request is not answered or the socket is open to other
+// users.
+#include "Server.hpp"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+int connectTo(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+        return fd;
+    if (fd >= 0) ::close(fd);
+    return -1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: jorgescript_idle_client_test <socket>\n";
+        return 2;
+    }
+    std::string path = argv[1];
+    Server::stop(path);
+
+    std::thread server([&] {
+        Server::serve(path, [](const std::vector<std::string>&, std::istream&) { return 7; });
+    });
+
+    int idle = -1;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while ((idle = connectTo(path)) < 0 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (idle < 0) {
+        std::cerr << "the server did not start\n";
+        return 1;
+    }
+
+    int failures = 0;
+    struct stat st{};
+    if (::stat(path.c_str(), &st) != 0 || (st.st_mode & 077) != 0) {
+        std::cerr << "the socket is open to other users (mode " << std::oct << (st.st_mode & 0777) << ")\n";
+        failures++;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int status = Server::request(path, "", {"script.jorge"}, nullptr);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (status != 7) {
+        std::cerr << "the request behind the idle client got " << status << '\n';
+        failures++;
+    }
+
+    ::close(idle);
+    Server::stop(path);
+    server.join();
+    std::cout << "answered after " << seconds << " s, " << failures << " failed\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+// Shared library loaded by the FFI tests and benchmarks. Every export uses
+// the CALL convention: argument count plus an array of pointer-sized values.
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#define TESTLIB_EXPORT extern "C" __declspec(dllexport)
+#define TESTLIB_CALL __stdcall
+#else
+#define TESTLIB_EXPORT extern "C" __attribute__((visibility("default")))
+#define TESTLIB_CALL
+#endif
+
+namespace {
+long long calls = 0;
+std::atomic<int> overlapping{0};
+std::atomic<int> mostOverlapping{0};
+}
+
+TESTLIB_EXPORT int TESTLIB_CALL jorge_noop(int, void**) {
+    return 0;
+}
+
+TESTLIB_EXPORT int TESTLIB_CALL jorge_count(int, void**) {
+    calls++;
+    return 0;
+}
+
+TESTLIB_EXPORT int TESTLIB_CALL jorge_report(int, void**) {
+    std::printf("count=%lld\n", calls);
+    std::fflush(stdout);
+    calls = 0;
+    return 0;
+}
+
+TESTLIB_EXPORT int TESTLIB_CALL jorge_sum(int argc, void** argv) {
+    intptr_t sum = 0;
+    for (int i = 0; i < argc; i++)
+        sum += reinterpret_cast<intptr_t>(argv[i]);
+    std::printf("sum=%lld\n", static_cast<long long>(sum));
+    std::fflush(stdout);
+    return 0;
+}
+
+TESTLIB_EXPORT int TESTLIB_CALL jorge_greet(int argc, void** argv) {
+#ifdef _WIN32
+    if (argc > 0) std::printf("hello, %ls\n", static_cast<const wchar_t*>(argv[0]));
+#else
+    if (argc > 0) std::printf("hello, %s\n", static_cast<const char*>(argv[0]));
+#endif
+    std::fflush(stdout);
+    return 0;
+}
+
+TESTLIB_EXPORT int TESTLIB_CALL jorge_print_doubles(int argc, void** argv) {
+    if (argc < 2) return 1;
+    const double* values = static_cast<const double*>(argv[0]);
+    intptr_t n = reinterpret_cast<intptr_t>(argv[1]);
+    for (intptr_t i = 0; i < n; i++)
+        std::printf("%g ", values[i]);
+    std::printf("\n");
+    std::fflush(stdout);
+    return 0;
+}
+
+// Plain C prototypes for DECLAREd calls.
+TESTLIB_EXPORT int64_t jorge_add(int64_t a, int64_t b) {
+    return a + b;
+}
+
+TESTLIB_EXPORT double jorge_scale(double x, int32_t times, double offset) {
+    return x * times + offset;
+}
+
+TESTLIB_EXPORT int32_t jorge_length(const char* text) {
+    int32_t n = 0;
+    while (text[n]) n++;
+    return n;
+}
+
+TESTLIB_EXPORT const char* jorge_name(int64_t which) {
+    return which ? "jorge" : nullptr;
+}
+
+TESTLIB_EXPORT bool jorge_is_even(int64_t n) {
+    return n % 2 == 0;
+}
+
+TESTLIB_EXPORT void jorge_store(int64_t n) {
+    calls = n;
+}
+
+TESTLIB_EXPORT double jorge_total(const double* values, int64_t n) {
+    double total = 0;
+    for (int64_t i = 0; i < n; i++)
+        total += values[i];
+    return total;
+}
+
+TESTLIB_EXPORT void jorge_double_all(double* values, int64_t n) {
+    for (int64_t i = 0; i < n; i++)
+        values[i] *= 2;
+}
+
+// Slow routines for ASYNC CALL: they sleep for `ms` before answering.
+TESTLIB_EXPORT int64_t jorge_slow_add(int64_t ms, int64_t a, int64_t b) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    return a + b;
+}
+
+TESTLIB_EXPORT const char* jorge_slow_upper(const char* text, int64_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    thread_local std::string upper;
+    upper = text;
+    for (char& c : upper)
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    return upper.c_str();
+}
+
+// Sleeps for `ms` and counts how many of these calls ran at the same time;
+// jorge_overlap_peak returns the highest count and starts again from 0.
+TESTLIB_EXPORT void jorge_overlap(int64_t ms) {
+    int now = ++overlapping;
+    int most = mostOverlapping.load();
+    while (now > most && !mostOverlapping.compare_exchange_weak(most, now)) {}
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    --overlapping;
+}
+
+TESTLIB_EXPORT int64_t jorge_overlap_peak() {
+    return mostOverlapping.exchange(0);
+}
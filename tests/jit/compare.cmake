@@ -0,0 +1,28 @@
+# Runs SCRIPT in the VM with and without --jit (and in the tree walker) and
+# fails when the outputs differ. With REQUIRE_JIT set, at least one loop of
+# the script has to have been compiled.
+function(run_script out)
+    execute_process(
+        COMMAND ${JORGESCRIPT} --no-cache ${ARGN} ${SCRIPT}
+        WORKING_DIRECTORY ${WORKING_DIRECTORY}
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE errors
+    )
+    set(${out} "${output}" PARENT_SCOPE)
+    set(${out}_ERRORS "${errors}" PARENT_SCOPE)
+endfunction()
+
+run_script(interpreted)
+run_script(tree_walk --tree-walk)
+run_script(jit --jit --stats)
+
+if (NOT jit STREQUAL interpreted)
+    message(FATAL_ERROR "--jit output differs from the VM:\n${jit}\n-- expected:\n${interpreted}")
+endif()
+if (NOT tree_walk STREQUAL interpreted)
+    message(FATAL_ERROR "tree walker output differs from the VM:\n${tree_walk}\n-- expected:\n${interpreted}")
+endif()
+if (REQUIRE_JIT AND NOT jit_ERRORS MATCHES "jit: [1-9][0-9]* loops compiled")
+    message(FATAL_ERROR "no loop was compiled:\n${jit_ERRORS}")
+endif()
+message(STATUS "${jit}${jit_ERRORS}")
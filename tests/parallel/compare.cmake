@@ -0,0 +1,42 @@
+# Runs SCRIPT with PARALLEL FOR on one and on several threads, in the VM,
+# the tree walker and with --jit, and fails unless every output matches a
+# run of the same script with each PARALLEL FOR turned into a plain FOR.
+# SHARED has to stop at its SET of a variable from outside the loop, after
+# printing what the iterations before it printed.
+function(run_script out script)
+    execute_process(
+        COMMAND ${JORGESCRIPT} --no-cache ${ARGN} ${script}
+        WORKING_DIRECTORY ${WORKING_DIRECTORY}
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE errors
+    )
+    set(${out} "${output}${errors}" PARENT_SCOPE)
+endfunction()
+
+file(READ ${WORKING_DIRECTORY}/${SCRIPT} source)
+string(REPLACE "PARALLEL FOR" "FOR" source "${source}")
+string(REGEX REPLACE " REDUCE [A-Z_, ]+ {" " {" source "${source}")
+file(WRITE ${BINARY_DIR}/sequential-${SCRIPT} "${source}")
+run_script(expected ${BINARY_DIR}/sequential-${SCRIPT})
+
+foreach(threads 1 4)
+    foreach(mode vm tree_walk jit)
+        set(flags --threads ${threads})
+        if (mode STREQUAL "tree_walk")
+            list(APPEND flags --tree-walk)
+        elseif (mode STREQUAL "jit")
+            list(APPEND flags --jit)
+        endif()
+        run_script(actual ${SCRIPT} ${flags})
+        if (NOT actual STREQUAL expected)
+            message(FATAL_ERROR "${mode} on ${threads} threads differs from FOR:\n${actual}\n-- expected:\n${expected}")
+        endif()
+    endforeach()
+endforeach()
+
+run_script(shared ${SHARED} --threads 4)
+string(REGEX MATCH "39\n40\nJorgeScript Error: Cannot SET SEEN inside PARALLEL FOR[^\n]*\n$" stopped "${shared}")
+if (NOT stopped OR shared MATCHES "41|unreachable")
+    message(FATAL_ERROR "${SHARED} did not stop at its shared SET:\n${shared}")
+endif()
+message(STATUS "${actual}")
@@ -0,0 +1,41 @@
+# Runs SCRIPT directly and twice through a server started by the first
+# --connect, and fails when the outputs differ. The second run has to find
+# the SUMMONed modules already parsed. A script piped to `-` has to run the
+# same way.
+function(run_script out)
+    execute_process(
+        COMMAND ${JORGESCRIPT} ${ARGN}
+        WORKING_DIRECTORY ${WORKING_DIRECTORY}
+        INPUT_FILE ${WORKING_DIRECTORY}/${SCRIPT}
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE errors
+        RESULT_VARIABLE status
+    )
+    set(${out} "${output}" PARENT_SCOPE)
+    set(${out}_ERRORS "${errors}" PARENT_SCOPE)
+    set(${out}_STATUS "${status}" PARENT_SCOPE)
+endfunction()
+
+execute_process(COMMAND ${JORGESCRIPT} --connect ${SOCKET} --stop OUTPUT_QUIET ERROR_QUIET)
+
+run_script(direct --no-cache ${SCRIPT})
+run_script(cold --connect ${SOCKET} --no-cache --stats ${SCRIPT})
+run_script(warm --connect ${SOCKET} --no-cache --stats ${SCRIPT})
+run_script(piped --connect ${SOCKET} --no-cache -)
+run_script(stopped --connect ${SOCKET} --stop)
+
+foreach(run cold warm piped)
+    if (NOT ${run} STREQUAL direct)
+        message(FATAL_ERROR "${run} run through the server differs:\n${${run}}${${run}_ERRORS}\n-- expected:\n${direct}")
+    endif()
+endforeach()
+if (cold_ERRORS MATCHES "running in this process")
+    message(FATAL_ERROR "no server was started:\n${cold_ERRORS}")
+endif()
+if (NOT warm_ERRORS MATCHES "modules: [1-9][0-9]* hits, 0 misses, 0 prefetched")
+    message(FATAL_ERROR "the second run parsed its modules again:\n${warm_ERRORS}")
+endif()
+if (NOT stopped_STATUS EQUAL 0)
+    message(FATAL_ERROR "the server did not stop:\n${stopped_ERRORS}")
+endif()
+message(STATUS "${warm}${warm_ERRORS}")
@@ -0,0 +1,16 @@
+# A script read through a pipe (/dev/stdin fed by another process, as with
+# `jorgescript <(...)`) has to run in full, not as an empty file.
+execute_process(
+    COMMAND ${CMAKE_COMMAND} -E cat ${SCRIPT}
+    COMMAND ${JORGESCRIPT} --no-cache /dev/stdin
+    OUTPUT_VARIABLE piped
+    ERROR_VARIABLE piped_errors
+)
+execute_process(
+    COMMAND ${JORGESCRIPT} --no-cache ${SCRIPT}
+    OUTPUT_VARIABLE direct
+)
+
+if (NOT piped MATCHES "bias " OR NOT piped STREQUAL direct)
+    message(FATAL_ERROR "piped script printed:\n${piped}${piped_errors}\n-- expected:\n${direct}")
+endif()
@@ -0,0 +1,30 @@
+# A script with more distinct literals and variables than fit in 16 bits
+# has to run in the VM as it does in the tree walker.
+set(script ${BINARY_DIR}/limits.jorge)
+file(WRITE ${script} "SET X TO 0;\n")
+# Written a thousand lines at a time; one growing string is quadratic.
+foreach(block RANGE 0 69)
+    set(text "")
+    foreach(line RANGE 1 1000)
+        math(EXPR i "${block} * 1000 + ${line}")
+        string(APPEND text "SET V${i} TO ${i};\nSET X TO X + 1;\n")
+    endforeach()
+    file(APPEND ${script} "${text}")
+endforeach()
+file(APPEND ${script} "PRINT V1 + V70000;\nPRINT X;\n")
+
+foreach(mode vm tree_walk)
+    set(flags --no-cache)
+    if (mode STREQUAL "tree_walk")
+        list(APPEND flags --tree-walk)
+    endif()
+    execute_process(
+        COMMAND ${JORGESCRIPT} ${flags} ${script}
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE errors
+    )
+    if (NOT output MATCHES "70001[\r\n]+70000[\r\n]*$" OR errors)
+        message(FATAL_ERROR "${mode} printed:\n${output}${errors}")
+    endif()
+endforeach()
+file(REMOVE ${script})
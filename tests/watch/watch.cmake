@@ -0,0 +1,66 @@
+# Runs main.jorge under --watch in a scratch copy of this directory and
+# edits its files while it watches: a change to second.jorge must only run
+# the last segment again, one to first.jorge everything from its SUMMON
+# on, and one to main.jorge the whole script. With EDITOR set, this script
+# is the editor instead; its stdout is the watcher's stdin, so the watch
+# ends when it exits.
+function(edit file text)
+    execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 0.7)
+    file(WRITE ${DIR}/${file} "${text}")
+endfunction()
+
+if (EDITOR)
+    edit(second.jorge "PRINT \"second v2\";\nSET C TO B + 200;\n")
+    edit(first.jorge "PRINT \"first v2\";\nSET B TO BASE + 20;\n")
+    edit(main.jorge "SET BASE TO 5;\nPRINT \"main v2\";\nSUMMON \"first.jorge\";\nPRINT \"after first \" + B;\nSUMMON \"second.jorge\" AS SECOND;\nPRINT \"after second \" + C;\n")
+    execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 0.7)
+    return()
+endif()
+
+set(expected
+"Running JorgeScript
+main runs
+first runs
+after first 11.000000
+second runs
+after second 111.000000
+second v2
+after second 211.000000
+first v2
+after first 21.000000
+second v2
+after second 221.000000
+main v2
+first v2
+after first 25.000000
+second v2
+after second 225.000000
+")
+
+foreach(mode vm tree_walk)
+    set(dir ${BINARY_DIR}/watch_${mode})
+    file(REMOVE_RECURSE ${dir})
+    file(MAKE_DIRECTORY ${dir})
+    file(COPY ${CMAKE_CURRENT_LIST_DIR}/main.jorge ${CMAKE_CURRENT_LIST_DIR}/first.jorge
+              ${CMAKE_CURRENT_LIST_DIR}/second.jorge DESTINATION ${dir})
+    set(flags --no-cache)
+    if (mode STREQUAL "tree_walk")
+        list(APPEND flags --tree-walk)
+    endif()
+
+    execute_process(
+        COMMAND ${CMAKE_COMMAND} -DEDITOR=ON -DDIR=${dir} -P ${CMAKE_CURRENT_LIST_FILE}
+        COMMAND ${JORGESCRIPT} --watch ${flags} main.jorge
+        WORKING_DIRECTORY ${dir}
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE errors
+        TIMEOUT 60
+    )
+    if (NOT output STREQUAL expected)
+        message(FATAL_ERROR "${mode}: unexpected output:\n${output}${errors}\n-- expected:\n${expected}")
+    endif()
+    if (NOT errors MATCHES "second.jorge in [0-9.]+ ms .*from segment 3 of 3.*first.jorge in .*from segment 2 of 3.*main.jorge in .*from segment 1 of 3")
+        message(FATAL_ERROR "${mode}: reloads not reported as expected:\n${errors}")
+    endif()
+    message(STATUS "${mode}:\n${errors}")
+endforeach()